@@ -0,0 +1,160 @@
+// Neighbour scans on grids stored in each cell order of cell_order.h. Does
+// not need R, build from the package root with
+//   g++ -O2 -std=c++11 -Isrc bench/cell_order.cpp src/cell_order.cpp src/interaction_kernel.cpp -o cell_order
+// and run ./cell_order. Cells are as wide as the cutoff and hold 4 specimens
+// on average. "sweep" scans the stencil of every specimen cell by cell in
+// storage order, like the initial death rates, "events" does it for random
+// points, like births and deaths. Pairs/s counts every specimen a scan
+// measures the distance to.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "cell_order.h"
+#include "interaction_kernel.h"
+#include "specimen_arena.h"
+
+template <int Dim>
+struct Grid {
+  int Count;
+  VEC<int> CellAtRowMajor;
+  VEC<int> RowMajor;
+  SpecimenArena<Dim> Arena;
+
+  Grid(const std::string& order, int count, const VEC<double>& coords)
+    : Count(count)
+  {
+    int counts[Dim];
+    int total = 1;
+    for (int axis = 0; axis < Dim; ++axis) {
+      counts[axis] = count;
+      total *= count;
+    }
+    RowMajor = CellOrder::RowMajorIndices(order, counts, Dim);
+    CellAtRowMajor.resize(total);
+    for (int cell = 0; cell < total; ++cell) {
+      CellAtRowMajor[RowMajor[cell]] = cell;
+    }
+    Arena = SpecimenArena<Dim>(total);
+    for (size_t i = 0; i < coords.size(); i += Dim) {
+      Arena.Add(CellOf(&coords[i]), &coords[i], 0);
+    }
+    Arena.Repack();
+  }
+
+  int CellOf(const double* point) const {
+    int position = 0;
+    for (int axis = Dim - 1; axis >= 0; --axis) {
+      position = position * Count + std::min<int>(point[axis], Count - 1);
+    }
+    return CellAtRowMajor[position];
+  }
+
+  // Scans the 3^Dim cells around the one at index, returns the specimens measured
+  long long Scan(const InteractionKernel& kernel, const int* index, const double* point, VEC<int>& slots, VEC<double>& squared) const {
+    long long pairs = 0;
+    for (int offset = 0; offset < (Dim == 1 ? 3 : Dim == 2 ? 9 : 27); ++offset) {
+      int position = 0;
+      double shift[Dim];
+      for (int axis = Dim - 1, rest = offset; axis >= 0; --axis, rest /= 3) {
+        int n = index[axis] + rest % 3 - 1;
+        int wrapped = (n + Count) % Count;
+        shift[axis] = wrapped - n;
+        position = position * Count + wrapped;
+      }
+      int cell = CellAtRowMajor[position];
+      const double* coords[Dim];
+      for (int axis = 0; axis < Dim; ++axis) {
+        coords[axis] = Arena.Coords(axis, cell);
+        shift[axis] = -shift[axis];
+      }
+      int size = Arena.CellSize(cell);
+      if (slots.size() < size + InteractionKernel::Padding) {
+        slots.resize(2 * (size + InteractionKernel::Padding));
+        squared.resize(2 * (size + InteractionKernel::Padding));
+      }
+      kernel.Scan<Dim>(point, coords, shift, size, 1.0, -1, slots.data(), squared.data());
+      pairs += size;
+    }
+    return pairs;
+  }
+};
+
+template <int Dim>
+static void Compare(int count) {
+  const char* orders[] = {"row_major", "morton", "hilbert"};
+  const double occupancy = 4;
+  std::mt19937 rng(42);
+  double cells = 1;
+  for (int axis = 0; axis < Dim; ++axis) {
+    cells *= count;
+  }
+  std::uniform_real_distribution<double> inside(0, count);
+  VEC<double> coords(static_cast<size_t>(cells * occupancy) * Dim);
+  for (auto &coord : coords) {
+    coord = inside(rng);
+  }
+  VEC<double> points(1 << 20);
+  for (auto &coord : points) {
+    coord = inside(rng);
+  }
+  InteractionKernel kernel("auto");
+  VEC<int> slots;
+  VEC<double> squared;
+
+  double base[2] = {0, 0};
+  for (const char* order : orders) {
+    Grid<Dim> grid(order, count, coords);
+    double rates[2];
+    for (int mode = 0; mode < 2; ++mode) {
+      long long pairs = 0;
+      auto start = std::chrono::steady_clock::now();
+      double elapsed = 0;
+      while (elapsed < 0.5) {
+        if (mode == 0) {
+          for (int cell = 0; cell < grid.CellAtRowMajor.size(); ++cell) {
+            int index[Dim];
+            for (int axis = 0, rest = grid.RowMajor[cell]; axis < Dim; ++axis, rest /= count) {
+              index[axis] = rest % count;
+            }
+            for (int k = 0; k < grid.Arena.CellSize(cell); ++k) {
+              double point[Dim];
+              for (int axis = 0; axis < Dim; ++axis) {
+                point[axis] = grid.Arena.Coords(axis, cell)[k];
+              }
+              pairs += grid.Scan(kernel, index, point, slots, squared);
+            }
+          }
+        } else {
+          for (size_t i = 0; i + Dim <= points.size(); i += Dim) {
+            int index[Dim];
+            for (int axis = 0; axis < Dim; ++axis) {
+              index[axis] = std::min<int>(points[i + axis], count - 1);
+            }
+            pairs += grid.Scan(kernel, index, &points[i], slots, squared);
+          }
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+      rates[mode] = pairs / elapsed;
+      if (std::string(order) == "row_major") {
+        base[mode] = rates[mode];
+      }
+    }
+    std::printf("%-4d %-10.0f %-10s %10.1f %9.2fx %10.1f %9.2fx\n", Dim, cells, order,
+                rates[0] / 1e6, rates[0] / base[0], rates[1] / 1e6, rates[1] / base[1]);
+  }
+}
+
+int main() {
+  std::printf("%-4s %-10s %-10s %10s %10s %10s %10s\n", "dim", "cells", "order", "sweep", "", "events", "");
+  std::printf("%-4s %-10s %-10s %10s %10s %10s %10s\n", "", "", "", "Mpairs/s", "vs row", "Mpairs/s", "vs row");
+  for (int count : {64, 512, 1024}) {
+    Compare<2>(count);
+  }
+  for (int count : {16, 64, 128}) {
+    Compare<3>(count);
+  }
+  return 0;
+}
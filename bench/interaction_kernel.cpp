@@ -0,0 +1,96 @@
+// Neighbour scan throughput of every interaction kernel the CPU supports.
+// Does not need R, build from the package root with
+//   g++ -O2 -std=c++11 -Isrc bench/interaction_kernel.cpp src/interaction_kernel.cpp -o interaction_kernel
+// and run ./interaction_kernel. Pairs/s counts every specimen a kernel
+// measures the distance to, whether it is kept or not.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "interaction_kernel.h"
+
+template <int Dim>
+static double PairsPerSecond(const InteractionKernel& kernel, int cellSize, double keptShare) {
+  const int cells = 1 << 12;
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> unit(0, 1);
+
+  // A cell of unit side per stencil entry, all as long as cellSize
+  VEC<double> coords[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    coords[axis].resize(cells * cellSize);
+    for (auto &coord : coords[axis]) {
+      coord = unit(rng);
+    }
+  }
+  // Cutoff of a ball around the cell centre that keeps about keptShare of the specimens
+  double cutoffSquared = 0;
+  {
+    VEC<double> squared(cellSize * 64);
+    for (auto &value : squared) {
+      value = 0;
+      for (int axis = 0; axis < Dim; ++axis) {
+        double delta = unit(rng) - 0.5;
+        value += delta * delta;
+      }
+    }
+    std::sort(squared.begin(), squared.end());
+    cutoffSquared = squared[static_cast<int>(keptShare * (squared.size() - 1))];
+  }
+  double point[Dim], shift[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    point[axis] = 0.5;
+    shift[axis] = 0;
+  }
+  VEC<int> slots(cellSize + InteractionKernel::Padding);
+  VEC<double> squaredDistances(cellSize + InteractionKernel::Padding);
+
+  long long pairs = 0, found = 0;
+  auto start = std::chrono::steady_clock::now();
+  double elapsed = 0;
+  while (elapsed < 0.5) {
+    for (int cell = 0; cell < cells; ++cell) {
+      const double* cellCoords[Dim];
+      for (int axis = 0; axis < Dim; ++axis) {
+        cellCoords[axis] = coords[axis].data() + cell * cellSize;
+      }
+      found += kernel.Scan<Dim>(point, cellCoords, shift, cellSize, cutoffSquared, -1,
+                                slots.data(), squaredDistances.data());
+    }
+    pairs += static_cast<long long>(cells) * cellSize;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  // Keeps the scans from being optimised away
+  if (found < 0) {
+    std::printf("%lld\n", found);
+  }
+  return pairs / elapsed;
+}
+
+int main() {
+  const char* kinds[] = {"scalar", "avx2", "avx512"};
+  const int cellSizes[] = {4, 8, 32, 128};
+
+  std::printf("%-4s %-9s %-8s %14s %14s\n", "dim", "cell size", "kernel", "Mpairs/s", "vs scalar");
+  for (int dim = 1; dim <= 3; ++dim) {
+    for (int cellSize : cellSizes) {
+      double scalar = 0;
+      for (const char* kind : kinds) {
+        if (!InteractionKernel::IsSupported(kind)) {
+          continue;
+        }
+        InteractionKernel kernel(kind);
+        double rate = dim == 1 ? PairsPerSecond<1>(kernel, cellSize, 0.3)
+                    : dim == 2 ? PairsPerSecond<2>(kernel, cellSize, 0.3)
+                    : PairsPerSecond<3>(kernel, cellSize, 0.3);
+        if (kernel.Kind() == "scalar") {
+          scalar = rate;
+        }
+        std::printf("%-4d %-9d %-8s %14.1f %13.2fx\n", dim, cellSize, kind, rate / 1e6, rate / scalar);
+      }
+    }
+  }
+  return 0;
+}
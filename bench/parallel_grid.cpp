@@ -0,0 +1,147 @@
+// Speedup of the "parallel_grid" engine with the thread count, in both
+// parallel modes. The engine is built from an Rcpp list, so this one needs R,
+// Rcpp and BH; build from the package root with
+//   g++ -O2 -std=c++11 -Isrc $(R CMD config --cppflags)
+//     -I$(Rscript -e 'cat(system.file("include", package = "Rcpp"))')
+//     -I$(Rscript -e 'cat(system.file("include", package = "BH"))')
+//     bench/parallel_grid.cpp src/sum_tree.cpp src/rate_sampler.cpp
+//     src/composition_rejection.cpp src/specimen_index.cpp src/kernel_table.cpp
+//     src/interaction_kernel.cpp src/worker_pool.cpp
+//     $(R CMD config --ldflags) -lpthread -o parallel_grid
+// on one line
+// and run ./parallel_grid, or ./parallel_grid 1 4 16 for chosen thread counts
+// (by default powers of two up to the core count). The population is 60000
+// specimens at their equilibrium density in 2d, on cells as wide as the death
+// cutoff, with time_window 0.1. Each run first makes one event per specimen,
+// timed as "warm-up" since the optimistic mode shrinks its steps from
+// time_window on the first window, then two per specimen, which the other
+// columns are for. "speedup" is against one thread of the same mode, which is
+// run first whether or not 1 is among the thread counts asked for. For
+// "window" "border" is border_events and "deferred" deferred_births per event,
+// for "optimistic" "rolled back" is rolled_back_events per committed event.
+// So far it has only been run on one core, so how far the engine scales past
+// that is not measured yet.
+#include <Rembedded.h>
+#include <Rcpp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "parallel_grid.h"
+
+static Rcpp::List Params(const std::string& mode, int threads) {
+  const int count = 60000;
+  const double sd = 0.3;
+  const double cutoff = 1;
+  // Equilibrium density is 1 / (dd * 0.5), the death kernel integrating to 0.5
+  const double dd = 0.2;
+  const double length = std::sqrt(count * dd * 0.5);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> unit(0, length);
+  VEC<double> xs(count);
+  VEC<double> ys(count);
+  for (int i = 0; i < count; ++i) {
+    xs[i] = unit(rng);
+    ys[i] = unit(rng);
+  }
+
+  // dnorm(r, sd = sd)^2 and the Rayleigh quantiles of initialize_simulator in 2d
+  VEC<double> deathY(101);
+  for (int i = 0; i <= 100; ++i) {
+    double r = cutoff * i / 100;
+    deathY[i] = std::exp(-r * r / (sd * sd)) / (2 * M_PI * sd * sd);
+  }
+  VEC<double> birthY(101);
+  for (int i = 0; i <= 100; ++i) {
+    double q = (1 - 1e-6) * i / 100;
+    birthY[i] = sd * std::sqrt(-2 * std::log(1 - q));
+  }
+
+  Rcpp::List params;
+  params["area_length_x"] = length;
+  params["area_length_y"] = length;
+  params["cell_count_x"] = static_cast<int>(length / cutoff);
+  params["cell_count_y"] = static_cast<int>(length / cutoff);
+  params["initial_population_x"] = xs;
+  params["initial_population_y"] = ys;
+  params["b"] = 1.0;
+  params["d"] = 0.0;
+  params["dd"] = dd;
+  params["seed"] = 1234;
+  params["death_r"] = cutoff;
+  params["death_y"] = deathY;
+  params["birth_ircdf_y"] = birthY;
+  params["periodic"] = true;
+  params["realtime_limit"] = 1e9;
+  params["threads"] = threads;
+  params["time_window"] = 0.1;
+  params["parallel_mode"] = mode;
+  return params;
+}
+
+// Runs events on the simulator, returning microseconds per event
+static double Time(Parallel_nd<2>& sim, int events) {
+  int before = sim.event_count;
+  auto start = std::chrono::steady_clock::now();
+  sim.run_events(events);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds / (sim.event_count - before) * 1e6;
+}
+
+static void Run(const std::string& mode, const VEC<int>& threadCounts) {
+  double single = 0;
+  for (int threads : threadCounts) {
+    Parallel_nd<2> sim(Params(mode, threads));
+    double warmUp = Time(sim, sim.total_population);
+
+    int events = sim.event_count;
+    int borders = sim.border_events;
+    int births = sim.deferred_births;
+    int rolledBack = sim.rolled_back_events;
+    double perEvent = Time(sim, 2 * sim.total_population);
+    events = sim.event_count - events;
+    if (threads == 1) {
+      single = perEvent;
+    }
+    std::printf("%-10s %7d %9d %10.2f %10.2f %8.2fx", mode.c_str(), threads, events, warmUp, perEvent, single / perEvent);
+    if (mode == "window") {
+      std::printf(" %8.3f %8.3f\n", static_cast<double>(sim.border_events - borders) / events,
+                  static_cast<double>(sim.deferred_births - births) / events);
+    } else {
+      std::printf(" %11.3f\n", static_cast<double>(sim.rolled_back_events - rolledBack) / events);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  VEC<int> threadCounts;
+  for (int i = 1; i < argc; ++i) {
+    threadCounts.push_back(std::atoi(argv[i]));
+  }
+  if (threadCounts.empty()) {
+    int cores = std::max<int>(std::thread::hardware_concurrency(), 1);
+    for (int threads = 1; threads <= cores; threads *= 2) {
+      threadCounts.push_back(threads);
+    }
+  }
+  // Speedups are measured against one thread, so that is always run, first
+  threadCounts.erase(std::remove(threadCounts.begin(), threadCounts.end(), 1), threadCounts.end());
+  threadCounts.insert(threadCounts.begin(), 1);
+
+  const char* rArgs[] = {"R", "--silent", "--vanilla"};
+  Rf_initEmbeddedR(3, const_cast<char**>(rArgs));
+  std::printf("%-10s %7s %9s %10s %10s %9s %8s %8s\n", "mode", "threads", "events", "warm-up", "us/event", "speedup", "border",
+              "deferred");
+  Run("window", threadCounts);
+  std::printf("%-10s %7s %9s %10s %10s %9s %11s\n", "mode", "threads", "events", "warm-up", "us/event", "speedup",
+              "rolled back");
+  Run("optimistic", threadCounts);
+  Rf_endEmbeddedR(0);
+  return 0;
+}
@@ -0,0 +1,306 @@
+// Births and deaths on the adaptive tree of spatial_tree.h against a grid of
+// cells sized for the mean density, as auto_cell_count sizes them, on uniform
+// and clustered populations. Does not need R, build from the package root with
+//   g++ -O2 -std=c++11 -Isrc bench/spatial_tree.cpp src/sum_tree.cpp -o spatial_tree
+// and run ./spatial_tree. The interaction is a constant within the cutoff,
+// so the times are those of the index: picking the dying specimen and the
+// parent, and updating the neighbours of each. Clusters are Gaussian clumps
+// of 2000 specimens, the pattern short birth dispersal produces, so cells
+// within them hold hundreds of specimens of which few are within the cutoff.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "spatial_tree.h"
+#include "sum_tree.h"
+
+template <int Dim>
+struct Point {
+  double Coords[Dim];
+  double Rate;
+};
+
+// Rates of the cells in one tree and counts in another, for the dying
+// specimen and the parent
+template <int Dim>
+class CellGrid {
+  int Count;
+  double Side;
+  double Cutoff;
+  MAT<Point<Dim>> Cells;
+  SumTree Rates;
+  SumTree Counts;
+
+  int CellOf(const double* coords) const {
+    int cell = 0;
+    for (int axis = Dim - 1; axis >= 0; --axis) {
+      int index = std::min(static_cast<int>(coords[axis] / Side), Count - 1);
+      cell = cell * Count + index;
+    }
+    return cell;
+  }
+
+  double CellRate(int cell) const {
+    double sum = 0;
+    for (const auto& point : Cells[cell]) {
+      sum += point.Rate;
+    }
+    return sum;
+  }
+
+  void AddAround(const double* coords, double change, double& own) {
+    int index[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      index[axis] = std::min(static_cast<int>(coords[axis] / Side), Count - 1);
+    }
+    int offset[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      offset[axis] = -1;
+    }
+    while (true) {
+      int cell = 0;
+      bool inside = true;
+      for (int axis = Dim - 1; axis >= 0; --axis) {
+        int at = index[axis] + offset[axis];
+        inside = inside && at >= 0 && at < Count;
+        cell = cell * Count + at;
+      }
+      if (inside && !Cells[cell].empty()) {
+        for (auto& point : Cells[cell]) {
+          double squared = 0;
+          for (int axis = 0; axis < Dim; ++axis) {
+            double delta = point.Coords[axis] - coords[axis];
+            squared += delta * delta;
+          }
+          if (squared <= Cutoff * Cutoff) {
+            point.Rate += change;
+            own += change;
+          }
+        }
+        Rates.Set(cell, CellRate(cell));
+      }
+      int axis = 0;
+      while (axis < Dim && ++offset[axis] == 2) {
+        offset[axis++] = -1;
+      }
+      if (axis == Dim) {
+        break;
+      }
+    }
+  }
+
+public:
+  // Cells are no narrower than the cutoff and hold 6 specimens on average
+  CellGrid(double length, double cutoff, int population)
+    : Count(static_cast<int>(length / std::max(cutoff, std::pow(6 * std::pow(length, Dim) / population, 1.0 / Dim))))
+    , Side(length / Count)
+    , Cutoff(cutoff)
+  {
+    int cells = 1;
+    for (int axis = 0; axis < Dim; ++axis) {
+      cells *= Count;
+    }
+    Cells.resize(cells);
+    Rates.Resize(cells);
+    Counts.Resize(cells);
+  }
+
+  int Size() const {
+    return static_cast<int>(Counts.Total() + 0.5);
+  }
+
+  void Insert(const double* coords) {
+    double own = 1;
+    AddAround(coords, 1, own);
+    int cell = CellOf(coords);
+    Point<Dim> point;
+    for (int axis = 0; axis < Dim; ++axis) {
+      point.Coords[axis] = coords[axis];
+    }
+    point.Rate = own;
+    Cells[cell].push_back(point);
+    Rates.Set(cell, CellRate(cell));
+    Counts.Set(cell, Cells[cell].size());
+  }
+
+  // The cell is drawn with u, the specimen within it with v
+  void Kill(double u, double v) {
+    int cell = Rates.Find(u * Rates.Total());
+    auto& members = Cells[cell];
+    double left = v * CellRate(cell);
+    int k = 0;
+    while (k + 1 < static_cast<int>(members.size()) && left >= members[k].Rate) {
+      left -= members[k++].Rate;
+    }
+    double coords[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      coords[axis] = members[k].Coords[axis];
+    }
+    members[k] = members.back();
+    members.pop_back();
+    Rates.Set(cell, CellRate(cell));
+    Counts.Set(cell, members.size());
+    double own = 0;
+    AddAround(coords, -1, own);
+  }
+
+  const double* Parent(double u) const {
+    int cell = Counts.Find(u * Counts.Total());
+    const auto& members = Cells[cell];
+    int k = std::min(static_cast<int>(u * members.size()), static_cast<int>(members.size()) - 1);
+    return members[k].Coords;
+  }
+};
+
+template <int Dim>
+class TreeIndex {
+  SpatialTree<Dim> Tree;
+  double Cutoff;
+
+  void AddAround(const double* coords, double change, double& own) {
+    double lo[Dim], hi[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      lo[axis] = coords[axis] - Cutoff;
+      hi[axis] = coords[axis] + Cutoff;
+    }
+    Tree.Update(lo, hi, [&](const double* at, double rate) {
+      double squared = 0;
+      for (int axis = 0; axis < Dim; ++axis) {
+        double delta = at[axis] - coords[axis];
+        squared += delta * delta;
+      }
+      if (squared > Cutoff * Cutoff) {
+        return rate;
+      }
+      own += change;
+      return rate + change;
+    });
+  }
+
+public:
+  TreeIndex(double length, double cutoff, int leafSize)
+    : Cutoff(cutoff)
+  {
+    double lengths[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      lengths[axis] = length;
+    }
+    Tree = SpatialTree<Dim>(lengths, leafSize);
+  }
+
+  int Size() const {
+    return Tree.Count();
+  }
+
+  void Insert(const double* coords) {
+    double own = 1;
+    AddAround(coords, 1, own);
+    Tree.Insert(coords, own);
+  }
+
+  void Kill(double u, double) {
+    int dying = Tree.Find(u * Tree.Total());
+    double coords[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      coords[axis] = Tree.Coord(dying, axis);
+    }
+    Tree.Erase(dying);
+    double own = 0;
+    AddAround(coords, -1, own);
+  }
+
+  const double* Parent(double u) {
+    static double coords[Dim];
+    int parent = Tree.Select(std::min(static_cast<int>(u * Tree.Count()), Tree.Count() - 1));
+    for (int axis = 0; axis < Dim; ++axis) {
+      coords[axis] = Tree.Coord(parent, axis);
+    }
+    return coords;
+  }
+
+  const SpatialTree<Dim>& Get() const {
+    return Tree;
+  }
+};
+
+template <int Dim>
+static void Populate(VEC<Point<Dim>>& points, int count, double length, double width, bool clustered, std::mt19937& rng) {
+  std::uniform_real_distribution<double> unit(0, 1);
+  std::normal_distribution<double> spread(0, width);
+  VEC<Point<Dim>> centres(std::max(count / 2000, 1));
+  for (auto& centre : centres) {
+    for (int axis = 0; axis < Dim; ++axis) {
+      centre.Coords[axis] = length * (0.1 + 0.8 * unit(rng));
+    }
+  }
+  points.resize(count);
+  for (auto& point : points) {
+    const auto& centre = centres[rng() % centres.size()];
+    for (int axis = 0; axis < Dim; ++axis) {
+      double at = clustered ? centre.Coords[axis] + spread(rng) : length * unit(rng);
+      point.Coords[axis] = std::min(std::max(at, 0.0), length);
+    }
+  }
+}
+
+// Alternates deaths and births with a child near a uniform parent, so the
+// population keeps its size and pattern
+template <class Index, int Dim>
+static double NanosecondsPerEvent(Index& index, double length, double width, bool clustered, std::mt19937& rng) {
+  std::uniform_real_distribution<double> unit(0, 1);
+  std::normal_distribution<double> spread(0, clustered ? width / 4 : length / 4);
+  const int events = 200000;
+  auto start = std::chrono::steady_clock::now();
+  for (int event = 0; event < events; ++event) {
+    if (event % 2 == 0) {
+      double u = unit(rng);
+      index.Kill(u, unit(rng));
+    } else {
+      const double* parent = index.Parent(unit(rng));
+      double child[Dim];
+      for (int axis = 0; axis < Dim; ++axis) {
+        double at = parent[axis] + spread(rng);
+        child[axis] = at - length * std::floor(at / length);
+      }
+      index.Insert(child);
+    }
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / events * 1e9;
+}
+
+template <int Dim>
+static void Run(int count, double length, double cutoff, double width) {
+  for (bool clustered : {false, true}) {
+    const char* pattern = clustered ? "clustered" : "uniform";
+    VEC<Point<Dim>> points;
+    std::mt19937 rng(42);
+    Populate(points, count, length, width, clustered, rng);
+
+    CellGrid<Dim> grid(length, cutoff, count);
+    for (const auto& point : points) {
+      grid.Insert(point.Coords);
+    }
+    double gridTime = NanosecondsPerEvent<CellGrid<Dim>, Dim>(grid, length, width, clustered, rng);
+    std::printf("%-4d %-10s %-10s %12.0f\n", Dim, pattern, "grid", gridTime);
+
+    for (int leafSize : {8, 16, 32}) {
+      TreeIndex<Dim> tree(length, cutoff, leafSize);
+      for (const auto& point : points) {
+        tree.Insert(point.Coords);
+      }
+      double treeTime = NanosecondsPerEvent<TreeIndex<Dim>, Dim>(tree, length, width, clustered, rng);
+      std::string name = "tree/" + std::to_string(leafSize);
+      std::printf("%-4d %-10s %-10s %12.0f %9.2fx %7d %7d\n", Dim, pattern, name.c_str(), treeTime,
+                  gridTime / treeTime, tree.Get().LeafCount(), tree.Get().Height());
+    }
+  }
+}
+
+int main() {
+  std::printf("%-4s %-10s %-10s %12s %10s %7s %7s\n", "dim", "pattern", "index", "ns/event", "vs grid", "leaves", "height");
+  Run<2>(20000, 100, 0.2, 1);
+  Run<3>(20000, 25, 0.2, 1);
+  return 0;
+}
@@ -0,0 +1,77 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "parallel_grid.h"
+
+using namespace std;
+
+#ifndef POISSON_1D_PARALLEL_H
+#define POISSON_1D_PARALLEL_H
+
+typedef Parallel_nd < 1 > Parallel_1d;
+
+RCPP_EXPOSED_CLASS(poisson_1d_parallel)
+RCPP_MODULE(poisson_1d_parallel_module) {
+  using namespace Rcpp;
+  
+  class_ < Parallel_1d > ("poisson_1d_parallel")
+  .constructor < List > ("Creates an instance of 1d simulator running blocks of cells in parallel")
+  .property("area_length_x", & parallel_area_length_of < 1, 0 >)
+  .property("cell_count_x", & parallel_cell_count_of < 1, 0 >)
+  .property("block_count_x", & parallel_block_count_of < 1, 0 >)
+  .field_readonly("periodic", & Parallel_1d::periodic)
+  .field_readonly("sampler", & Parallel_1d::sampler)
+  .field_readonly("interaction_kernel", & Parallel_1d::interaction_kernel)
+  .field_readonly("threads", & Parallel_1d::threads)
+  .field_readonly("max_blocks", & Parallel_1d::max_blocks)
+  .field_readonly("block_count", & Parallel_1d::block_count)
+  .field_readonly("time_window", & Parallel_1d::time_window)
+  .field_readonly("parallel_mode", & Parallel_1d::parallel_mode)
+  
+  .field_readonly("b", & Parallel_1d::b)
+  .field_readonly("d", & Parallel_1d::d)
+  .field_readonly("dd", & Parallel_1d::dd)
+  
+  .field_readonly("seed", & Parallel_1d::seed)
+  .property("initial_population_x", & parallel_initial_population_of < 1, 0 >)
+  
+  .field_readonly("death_y", & Parallel_1d::death_y)
+  .field_readonly("death_cutoff_r", & Parallel_1d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Parallel_1d::death_spline_nodes)
+  .field_readonly("death_step", & Parallel_1d::death_step)
+  .field_readonly("death_kernel", & Parallel_1d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Parallel_1d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Parallel_1d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Parallel_1d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Parallel_1d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Parallel_1d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & parallel_all_coords_of < 1, 0 >)
+  .method("get_all_death_rates", & Parallel_1d::get_all_death_rates)
+  
+  .method("death_spline_at", & Parallel_1d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Parallel_1d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Parallel_1d::make_event)
+  .method("run_events", & Parallel_1d::run_events)
+  .method("run_for", & Parallel_1d::run_for)
+  
+  .field_readonly("total_population", & Parallel_1d::total_population)
+  .field_readonly("total_death_rate", & Parallel_1d::total_death_rate)
+  .field_readonly("events", & Parallel_1d::event_count)
+  .field_readonly("time", & Parallel_1d::time)
+  .field_readonly("windows", & Parallel_1d::window_count)
+  .field_readonly("border_events", & Parallel_1d::border_events)
+  .field_readonly("deferred_births", & Parallel_1d::deferred_births)
+  .field_readonly("rollbacks", & Parallel_1d::rollbacks)
+  .field_readonly("rolled_back_events", & Parallel_1d::rolled_back_events)
+  .field_readonly("messages", & Parallel_1d::messages)
+  
+  .field_readonly("realtime_limit", & Parallel_1d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Parallel_1d::realtime_limit_reached);
+}
+
+#endif
@@ -0,0 +1,64 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "poisson_tree.h"
+
+using namespace std;
+
+#ifndef POISSON_1D_SPARSE_H
+#define POISSON_1D_SPARSE_H
+
+typedef Tree_nd < 1, SparseGrid < 1 > > Sparse_1d;
+
+RCPP_EXPOSED_CLASS(poisson_1d_sparse)
+RCPP_MODULE(poisson_1d_sparse_module) {
+  using namespace Rcpp;
+  
+  class_ < Sparse_1d > ("poisson_1d_sparse")
+  .constructor < List > ("Creates an instance of 1d simulator on a hashed grid of occupied cells")
+  .property("area_length_x", & tree_area_length_of < 1, 0, SparseGrid < 1 > >)
+  .property("cell_count_x", & sparse_cell_count_of < 1, 0 >)
+  .field_readonly("periodic", & Sparse_1d::periodic)
+  
+  .field_readonly("b", & Sparse_1d::b)
+  .field_readonly("d", & Sparse_1d::d)
+  .field_readonly("dd", & Sparse_1d::dd)
+  
+  .field_readonly("seed", & Sparse_1d::seed)
+  .property("initial_population_x", & tree_initial_population_of < 1, 0, SparseGrid < 1 > >)
+  
+  .field_readonly("death_y", & Sparse_1d::death_y)
+  .field_readonly("death_cutoff_r", & Sparse_1d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Sparse_1d::death_spline_nodes)
+  .field_readonly("death_step", & Sparse_1d::death_step)
+  .field_readonly("death_kernel", & Sparse_1d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Sparse_1d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Sparse_1d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Sparse_1d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Sparse_1d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Sparse_1d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & tree_all_coords_of < 1, 0, SparseGrid < 1 > >)
+  .method("get_all_death_rates", & Sparse_1d::get_all_death_rates)
+  
+  .method("death_spline_at", & Sparse_1d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Sparse_1d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Sparse_1d::make_event)
+  .method("run_events", & Sparse_1d::run_events)
+  .method("run_for", & Sparse_1d::run_for)
+  
+  .field_readonly("total_population", & Sparse_1d::total_population)
+  .field_readonly("total_death_rate", & Sparse_1d::total_death_rate)
+  .property("occupied_cell_count", & sparse_occupied_cell_count_of < 1 >)
+  .field_readonly("events", & Sparse_1d::event_count)
+  .field_readonly("time", & Sparse_1d::time)
+  
+  .field_readonly("realtime_limit", & Sparse_1d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Sparse_1d::realtime_limit_reached);
+}
+
+#endif
@@ -0,0 +1,62 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "poisson_tree.h"
+
+using namespace std;
+
+#ifndef POISSON_1D_TREE_H
+#define POISSON_1D_TREE_H
+
+typedef Tree_nd < 1 > Tree_1d;
+
+RCPP_EXPOSED_CLASS(poisson_1d_tree)
+RCPP_MODULE(poisson_1d_tree_module) {
+  using namespace Rcpp;
+  
+  class_ < Tree_1d > ("poisson_1d_tree")
+  .constructor < List > ("Creates an instance of gridless 1d simulator")
+  .property("area_length_x", & tree_area_length_of < 1, 0 >)
+  .field_readonly("periodic", & Tree_1d::periodic)
+  
+  .field_readonly("b", & Tree_1d::b)
+  .field_readonly("d", & Tree_1d::d)
+  .field_readonly("dd", & Tree_1d::dd)
+  
+  .field_readonly("seed", & Tree_1d::seed)
+  .property("initial_population_x", & tree_initial_population_of < 1, 0 >)
+  
+  .field_readonly("death_y", & Tree_1d::death_y)
+  .field_readonly("death_cutoff_r", & Tree_1d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Tree_1d::death_spline_nodes)
+  .field_readonly("death_step", & Tree_1d::death_step)
+  .field_readonly("death_kernel", & Tree_1d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Tree_1d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Tree_1d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Tree_1d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Tree_1d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Tree_1d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & tree_all_coords_of < 1, 0 >)
+  .method("get_all_death_rates", & Tree_1d::get_all_death_rates)
+  
+  .method("death_spline_at", & Tree_1d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Tree_1d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Tree_1d::make_event)
+  .method("run_events", & Tree_1d::run_events)
+  .method("run_for", & Tree_1d::run_for)
+  
+  .field_readonly("total_population", & Tree_1d::total_population)
+  .field_readonly("total_death_rate", & Tree_1d::total_death_rate)
+  .field_readonly("events", & Tree_1d::event_count)
+  .field_readonly("time", & Tree_1d::time)
+  
+  .field_readonly("realtime_limit", & Tree_1d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Tree_1d::realtime_limit_reached);
+}
+
+#endif
@@ -0,0 +1,60 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "hybrid_grid.h"
+
+using namespace std;
+
+#ifndef POISSON_2D_HYBRID_H
+#define POISSON_2D_HYBRID_H
+
+typedef Hybrid_nd < 2 > Hybrid_2d;
+
+RCPP_EXPOSED_CLASS(poisson_2d_hybrid)
+RCPP_MODULE(poisson_2d_hybrid_module) {
+  using namespace Rcpp;
+  
+  class_ < Hybrid_2d > ("poisson_2d_hybrid")
+  .constructor < List > ("Creates an instance of 2d simulator keeping dense cells as a density field")
+  .property("area_length_x", & hybrid_area_length_of < 2, 0 >)
+  .property("area_length_y", & hybrid_area_length_of < 2, 1 >)
+  .property("cell_count_x", & hybrid_cell_count_of < 2, 0 >)
+  .property("cell_count_y", & hybrid_cell_count_of < 2, 1 >)
+  .property("periodic", & Hybrid_2d::get_periodic)
+  .field_readonly("continuum_threshold", & Hybrid_2d::continuum_threshold)
+  .field_readonly("field_step", & Hybrid_2d::field_step)
+  
+  .property("b", & Hybrid_2d::get_b)
+  .property("d", & Hybrid_2d::get_d)
+  .property("dd", & Hybrid_2d::get_dd)
+  
+  .property("seed", & Hybrid_2d::get_seed)
+  
+  .method("get_all_x_coordinates", & hybrid_all_coords_of < 2, 0 >)
+  .method("get_all_y_coordinates", & hybrid_all_coords_of < 2, 1 >)
+  .method("get_all_death_rates", & Hybrid_2d::get_all_death_rates)
+  .method("get_continuum_density", & Hybrid_2d::get_continuum_density)
+  
+  .method("death_spline_at", & Hybrid_2d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Hybrid_2d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Hybrid_2d::make_event)
+  .method("run_events", & Hybrid_2d::run_events)
+  .method("run_for", & Hybrid_2d::run_for)
+  
+  .property("total_population", & Hybrid_2d::get_total_population)
+  .property("total_death_rate", & Hybrid_2d::get_total_death_rate)
+  .property("continuum_mass", & Hybrid_2d::get_continuum_mass)
+  .property("continuum_cells", & Hybrid_2d::get_continuum_cells)
+  .property("events", & Hybrid_2d::get_events)
+  .field_readonly("continuum_events", & Hybrid_2d::continuum_events)
+  .field_readonly("field_steps", & Hybrid_2d::field_steps)
+  .property("time", & Hybrid_2d::get_time)
+  
+  .property("realtime_limit", & Hybrid_2d::get_realtime_limit)
+  .property("realtime_limit_reached", & Hybrid_2d::get_realtime_limit_reached);
+}
+
+#endif
@@ -0,0 +1,82 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "parallel_grid.h"
+
+using namespace std;
+
+#ifndef POISSON_2D_PARALLEL_H
+#define POISSON_2D_PARALLEL_H
+
+typedef Parallel_nd < 2 > Parallel_2d;
+
+RCPP_EXPOSED_CLASS(poisson_2d_parallel)
+RCPP_MODULE(poisson_2d_parallel_module) {
+  using namespace Rcpp;
+  
+  class_ < Parallel_2d > ("poisson_2d_parallel")
+  .constructor < List > ("Creates an instance of 2d simulator running blocks of cells in parallel")
+  .property("area_length_x", & parallel_area_length_of < 2, 0 >)
+  .property("area_length_y", & parallel_area_length_of < 2, 1 >)
+  .property("cell_count_x", & parallel_cell_count_of < 2, 0 >)
+  .property("cell_count_y", & parallel_cell_count_of < 2, 1 >)
+  .property("block_count_x", & parallel_block_count_of < 2, 0 >)
+  .property("block_count_y", & parallel_block_count_of < 2, 1 >)
+  .field_readonly("periodic", & Parallel_2d::periodic)
+  .field_readonly("sampler", & Parallel_2d::sampler)
+  .field_readonly("interaction_kernel", & Parallel_2d::interaction_kernel)
+  .field_readonly("threads", & Parallel_2d::threads)
+  .field_readonly("max_blocks", & Parallel_2d::max_blocks)
+  .field_readonly("block_count", & Parallel_2d::block_count)
+  .field_readonly("time_window", & Parallel_2d::time_window)
+  .field_readonly("parallel_mode", & Parallel_2d::parallel_mode)
+  
+  .field_readonly("b", & Parallel_2d::b)
+  .field_readonly("d", & Parallel_2d::d)
+  .field_readonly("dd", & Parallel_2d::dd)
+  
+  .field_readonly("seed", & Parallel_2d::seed)
+  .property("initial_population_x", & parallel_initial_population_of < 2, 0 >)
+  .property("initial_population_y", & parallel_initial_population_of < 2, 1 >)
+  
+  .field_readonly("death_y", & Parallel_2d::death_y)
+  .field_readonly("death_cutoff_r", & Parallel_2d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Parallel_2d::death_spline_nodes)
+  .field_readonly("death_step", & Parallel_2d::death_step)
+  .field_readonly("death_kernel", & Parallel_2d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Parallel_2d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Parallel_2d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Parallel_2d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Parallel_2d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Parallel_2d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & parallel_all_coords_of < 2, 0 >)
+  .method("get_all_y_coordinates", & parallel_all_coords_of < 2, 1 >)
+  .method("get_all_death_rates", & Parallel_2d::get_all_death_rates)
+  
+  .method("death_spline_at", & Parallel_2d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Parallel_2d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Parallel_2d::make_event)
+  .method("run_events", & Parallel_2d::run_events)
+  .method("run_for", & Parallel_2d::run_for)
+  
+  .field_readonly("total_population", & Parallel_2d::total_population)
+  .field_readonly("total_death_rate", & Parallel_2d::total_death_rate)
+  .field_readonly("events", & Parallel_2d::event_count)
+  .field_readonly("time", & Parallel_2d::time)
+  .field_readonly("windows", & Parallel_2d::window_count)
+  .field_readonly("border_events", & Parallel_2d::border_events)
+  .field_readonly("deferred_births", & Parallel_2d::deferred_births)
+  .field_readonly("rollbacks", & Parallel_2d::rollbacks)
+  .field_readonly("rolled_back_events", & Parallel_2d::rolled_back_events)
+  .field_readonly("messages", & Parallel_2d::messages)
+  
+  .field_readonly("realtime_limit", & Parallel_2d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Parallel_2d::realtime_limit_reached);
+}
+
+#endif
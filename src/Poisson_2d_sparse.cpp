@@ -0,0 +1,68 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "poisson_tree.h"
+
+using namespace std;
+
+#ifndef POISSON_2D_SPARSE_H
+#define POISSON_2D_SPARSE_H
+
+typedef Tree_nd < 2, SparseGrid < 2 > > Sparse_2d;
+
+RCPP_EXPOSED_CLASS(poisson_2d_sparse)
+RCPP_MODULE(poisson_2d_sparse_module) {
+  using namespace Rcpp;
+  
+  class_ < Sparse_2d > ("poisson_2d_sparse")
+  .constructor < List > ("Creates an instance of 2d simulator on a hashed grid of occupied cells")
+  .property("area_length_x", & tree_area_length_of < 2, 0, SparseGrid < 2 > >)
+  .property("area_length_y", & tree_area_length_of < 2, 1, SparseGrid < 2 > >)
+  .property("cell_count_x", & sparse_cell_count_of < 2, 0 >)
+  .property("cell_count_y", & sparse_cell_count_of < 2, 1 >)
+  .field_readonly("periodic", & Sparse_2d::periodic)
+  
+  .field_readonly("b", & Sparse_2d::b)
+  .field_readonly("d", & Sparse_2d::d)
+  .field_readonly("dd", & Sparse_2d::dd)
+  
+  .field_readonly("seed", & Sparse_2d::seed)
+  .property("initial_population_x", & tree_initial_population_of < 2, 0, SparseGrid < 2 > >)
+  .property("initial_population_y", & tree_initial_population_of < 2, 1, SparseGrid < 2 > >)
+  
+  .field_readonly("death_y", & Sparse_2d::death_y)
+  .field_readonly("death_cutoff_r", & Sparse_2d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Sparse_2d::death_spline_nodes)
+  .field_readonly("death_step", & Sparse_2d::death_step)
+  .field_readonly("death_kernel", & Sparse_2d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Sparse_2d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Sparse_2d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Sparse_2d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Sparse_2d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Sparse_2d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & tree_all_coords_of < 2, 0, SparseGrid < 2 > >)
+  .method("get_all_y_coordinates", & tree_all_coords_of < 2, 1, SparseGrid < 2 > >)
+  .method("get_all_death_rates", & Sparse_2d::get_all_death_rates)
+  
+  .method("death_spline_at", & Sparse_2d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Sparse_2d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Sparse_2d::make_event)
+  .method("run_events", & Sparse_2d::run_events)
+  .method("run_for", & Sparse_2d::run_for)
+  
+  .field_readonly("total_population", & Sparse_2d::total_population)
+  .field_readonly("total_death_rate", & Sparse_2d::total_death_rate)
+  .property("occupied_cell_count", & sparse_occupied_cell_count_of < 2 >)
+  .field_readonly("events", & Sparse_2d::event_count)
+  .field_readonly("time", & Sparse_2d::time)
+  
+  .field_readonly("realtime_limit", & Sparse_2d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Sparse_2d::realtime_limit_reached);
+}
+
+#endif
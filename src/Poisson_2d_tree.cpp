@@ -0,0 +1,66 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "poisson_tree.h"
+
+using namespace std;
+
+#ifndef POISSON_2D_TREE_H
+#define POISSON_2D_TREE_H
+
+typedef Tree_nd < 2 > Tree_2d;
+
+RCPP_EXPOSED_CLASS(poisson_2d_tree)
+RCPP_MODULE(poisson_2d_tree_module) {
+  using namespace Rcpp;
+  
+  class_ < Tree_2d > ("poisson_2d_tree")
+  .constructor < List > ("Creates an instance of 2d simulator on an adaptive quadtree")
+  .property("area_length_x", & tree_area_length_of < 2, 0 >)
+  .property("area_length_y", & tree_area_length_of < 2, 1 >)
+  .field_readonly("periodic", & Tree_2d::periodic)
+  .field_readonly("tree_leaf_size", & Tree_2d::tree_leaf_size)
+  
+  .field_readonly("b", & Tree_2d::b)
+  .field_readonly("d", & Tree_2d::d)
+  .field_readonly("dd", & Tree_2d::dd)
+  
+  .field_readonly("seed", & Tree_2d::seed)
+  .property("initial_population_x", & tree_initial_population_of < 2, 0 >)
+  .property("initial_population_y", & tree_initial_population_of < 2, 1 >)
+  
+  .field_readonly("death_y", & Tree_2d::death_y)
+  .field_readonly("death_cutoff_r", & Tree_2d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Tree_2d::death_spline_nodes)
+  .field_readonly("death_step", & Tree_2d::death_step)
+  .field_readonly("death_kernel", & Tree_2d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Tree_2d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Tree_2d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Tree_2d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Tree_2d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Tree_2d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & tree_all_coords_of < 2, 0 >)
+  .method("get_all_y_coordinates", & tree_all_coords_of < 2, 1 >)
+  .method("get_all_death_rates", & Tree_2d::get_all_death_rates)
+  
+  .method("death_spline_at", & Tree_2d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Tree_2d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Tree_2d::make_event)
+  .method("run_events", & Tree_2d::run_events)
+  .method("run_for", & Tree_2d::run_for)
+  
+  .field_readonly("total_population", & Tree_2d::total_population)
+  .field_readonly("total_death_rate", & Tree_2d::total_death_rate)
+  .field_readonly("events", & Tree_2d::event_count)
+  .field_readonly("time", & Tree_2d::time)
+  
+  .field_readonly("realtime_limit", & Tree_2d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Tree_2d::realtime_limit_reached);
+}
+
+#endif
@@ -0,0 +1,87 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "parallel_grid.h"
+
+using namespace std;
+
+#ifndef POISSON_3D_PARALLEL_H
+#define POISSON_3D_PARALLEL_H
+
+typedef Parallel_nd < 3 > Parallel_3d;
+
+RCPP_EXPOSED_CLASS(poisson_3d_parallel)
+RCPP_MODULE(poisson_3d_parallel_module) {
+  using namespace Rcpp;
+  
+  class_ < Parallel_3d > ("poisson_3d_parallel")
+  .constructor < List > ("Creates an instance of 3d simulator running blocks of cells in parallel")
+  .property("area_length_x", & parallel_area_length_of < 3, 0 >)
+  .property("area_length_y", & parallel_area_length_of < 3, 1 >)
+  .property("area_length_z", & parallel_area_length_of < 3, 2 >)
+  .property("cell_count_x", & parallel_cell_count_of < 3, 0 >)
+  .property("cell_count_y", & parallel_cell_count_of < 3, 1 >)
+  .property("cell_count_z", & parallel_cell_count_of < 3, 2 >)
+  .property("block_count_x", & parallel_block_count_of < 3, 0 >)
+  .property("block_count_y", & parallel_block_count_of < 3, 1 >)
+  .property("block_count_z", & parallel_block_count_of < 3, 2 >)
+  .field_readonly("periodic", & Parallel_3d::periodic)
+  .field_readonly("sampler", & Parallel_3d::sampler)
+  .field_readonly("interaction_kernel", & Parallel_3d::interaction_kernel)
+  .field_readonly("threads", & Parallel_3d::threads)
+  .field_readonly("max_blocks", & Parallel_3d::max_blocks)
+  .field_readonly("block_count", & Parallel_3d::block_count)
+  .field_readonly("time_window", & Parallel_3d::time_window)
+  .field_readonly("parallel_mode", & Parallel_3d::parallel_mode)
+  
+  .field_readonly("b", & Parallel_3d::b)
+  .field_readonly("d", & Parallel_3d::d)
+  .field_readonly("dd", & Parallel_3d::dd)
+  
+  .field_readonly("seed", & Parallel_3d::seed)
+  .property("initial_population_x", & parallel_initial_population_of < 3, 0 >)
+  .property("initial_population_y", & parallel_initial_population_of < 3, 1 >)
+  .property("initial_population_z", & parallel_initial_population_of < 3, 2 >)
+  
+  .field_readonly("death_y", & Parallel_3d::death_y)
+  .field_readonly("death_cutoff_r", & Parallel_3d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Parallel_3d::death_spline_nodes)
+  .field_readonly("death_step", & Parallel_3d::death_step)
+  .field_readonly("death_kernel", & Parallel_3d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Parallel_3d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Parallel_3d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Parallel_3d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Parallel_3d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Parallel_3d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & parallel_all_coords_of < 3, 0 >)
+  .method("get_all_y_coordinates", & parallel_all_coords_of < 3, 1 >)
+  .method("get_all_z_coordinates", & parallel_all_coords_of < 3, 2 >)
+  .method("get_all_death_rates", & Parallel_3d::get_all_death_rates)
+  
+  .method("death_spline_at", & Parallel_3d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Parallel_3d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Parallel_3d::make_event)
+  .method("run_events", & Parallel_3d::run_events)
+  .method("run_for", & Parallel_3d::run_for)
+  
+  .field_readonly("total_population", & Parallel_3d::total_population)
+  .field_readonly("total_death_rate", & Parallel_3d::total_death_rate)
+  .field_readonly("events", & Parallel_3d::event_count)
+  .field_readonly("time", & Parallel_3d::time)
+  .field_readonly("windows", & Parallel_3d::window_count)
+  .field_readonly("border_events", & Parallel_3d::border_events)
+  .field_readonly("deferred_births", & Parallel_3d::deferred_births)
+  .field_readonly("rollbacks", & Parallel_3d::rollbacks)
+  .field_readonly("rolled_back_events", & Parallel_3d::rolled_back_events)
+  .field_readonly("messages", & Parallel_3d::messages)
+  
+  .field_readonly("realtime_limit", & Parallel_3d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Parallel_3d::realtime_limit_reached);
+}
+
+#endif
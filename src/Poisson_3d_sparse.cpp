@@ -0,0 +1,72 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "poisson_tree.h"
+
+using namespace std;
+
+#ifndef POISSON_3D_SPARSE_H
+#define POISSON_3D_SPARSE_H
+
+typedef Tree_nd < 3, SparseGrid < 3 > > Sparse_3d;
+
+RCPP_EXPOSED_CLASS(poisson_3d_sparse)
+RCPP_MODULE(poisson_3d_sparse_module) {
+  using namespace Rcpp;
+  
+  class_ < Sparse_3d > ("poisson_3d_sparse")
+  .constructor < List > ("Creates an instance of 3d simulator on a hashed grid of occupied cells")
+  .property("area_length_x", & tree_area_length_of < 3, 0, SparseGrid < 3 > >)
+  .property("area_length_y", & tree_area_length_of < 3, 1, SparseGrid < 3 > >)
+  .property("area_length_z", & tree_area_length_of < 3, 2, SparseGrid < 3 > >)
+  .property("cell_count_x", & sparse_cell_count_of < 3, 0 >)
+  .property("cell_count_y", & sparse_cell_count_of < 3, 1 >)
+  .property("cell_count_z", & sparse_cell_count_of < 3, 2 >)
+  .field_readonly("periodic", & Sparse_3d::periodic)
+  
+  .field_readonly("b", & Sparse_3d::b)
+  .field_readonly("d", & Sparse_3d::d)
+  .field_readonly("dd", & Sparse_3d::dd)
+  
+  .field_readonly("seed", & Sparse_3d::seed)
+  .property("initial_population_x", & tree_initial_population_of < 3, 0, SparseGrid < 3 > >)
+  .property("initial_population_y", & tree_initial_population_of < 3, 1, SparseGrid < 3 > >)
+  .property("initial_population_z", & tree_initial_population_of < 3, 2, SparseGrid < 3 > >)
+  
+  .field_readonly("death_y", & Sparse_3d::death_y)
+  .field_readonly("death_cutoff_r", & Sparse_3d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Sparse_3d::death_spline_nodes)
+  .field_readonly("death_step", & Sparse_3d::death_step)
+  .field_readonly("death_kernel", & Sparse_3d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Sparse_3d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Sparse_3d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Sparse_3d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Sparse_3d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Sparse_3d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & tree_all_coords_of < 3, 0, SparseGrid < 3 > >)
+  .method("get_all_y_coordinates", & tree_all_coords_of < 3, 1, SparseGrid < 3 > >)
+  .method("get_all_z_coordinates", & tree_all_coords_of < 3, 2, SparseGrid < 3 > >)
+  .method("get_all_death_rates", & Sparse_3d::get_all_death_rates)
+  
+  .method("death_spline_at", & Sparse_3d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Sparse_3d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Sparse_3d::make_event)
+  .method("run_events", & Sparse_3d::run_events)
+  .method("run_for", & Sparse_3d::run_for)
+  
+  .field_readonly("total_population", & Sparse_3d::total_population)
+  .field_readonly("total_death_rate", & Sparse_3d::total_death_rate)
+  .property("occupied_cell_count", & sparse_occupied_cell_count_of < 3 >)
+  .field_readonly("events", & Sparse_3d::event_count)
+  .field_readonly("time", & Sparse_3d::time)
+  
+  .field_readonly("realtime_limit", & Sparse_3d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Sparse_3d::realtime_limit_reached);
+}
+
+#endif
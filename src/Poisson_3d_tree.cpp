@@ -0,0 +1,69 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <vector>
+
+#include "poisson_tree.h"
+
+using namespace std;
+
+#ifndef POISSON_3D_TREE_H
+#define POISSON_3D_TREE_H
+
+typedef Tree_nd < 3 > Tree_3d;
+
+RCPP_EXPOSED_CLASS(poisson_3d_tree)
+RCPP_MODULE(poisson_3d_tree_module) {
+  using namespace Rcpp;
+  
+  class_ < Tree_3d > ("poisson_3d_tree")
+  .constructor < List > ("Creates an instance of 3d simulator on an adaptive octree")
+  .property("area_length_x", & tree_area_length_of < 3, 0 >)
+  .property("area_length_y", & tree_area_length_of < 3, 1 >)
+  .property("area_length_z", & tree_area_length_of < 3, 2 >)
+  .field_readonly("periodic", & Tree_3d::periodic)
+  .field_readonly("tree_leaf_size", & Tree_3d::tree_leaf_size)
+  
+  .field_readonly("b", & Tree_3d::b)
+  .field_readonly("d", & Tree_3d::d)
+  .field_readonly("dd", & Tree_3d::dd)
+  
+  .field_readonly("seed", & Tree_3d::seed)
+  .property("initial_population_x", & tree_initial_population_of < 3, 0 >)
+  .property("initial_population_y", & tree_initial_population_of < 3, 1 >)
+  .property("initial_population_z", & tree_initial_population_of < 3, 2 >)
+  
+  .field_readonly("death_y", & Tree_3d::death_y)
+  .field_readonly("death_cutoff_r", & Tree_3d::death_cutoff_r)
+  .field_readonly("death_spline_nodes", & Tree_3d::death_spline_nodes)
+  .field_readonly("death_step", & Tree_3d::death_step)
+  .field_readonly("death_kernel", & Tree_3d::death_kernel)
+  .field_readonly("death_kernel_tolerance", & Tree_3d::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", & Tree_3d::death_kernel_max_error)
+  
+  .field_readonly("birth_inverse_rcdf_y", & Tree_3d::birth_inverse_rcdf_y)
+  .field_readonly("birth_inverse_rcdf_nodes", & Tree_3d::birth_inverse_rcdf_nodes)
+  .field_readonly("birth_inverse_rcdf_step", & Tree_3d::birth_inverse_rcdf_step)
+  
+  .method("get_all_x_coordinates", & tree_all_coords_of < 3, 0 >)
+  .method("get_all_y_coordinates", & tree_all_coords_of < 3, 1 >)
+  .method("get_all_z_coordinates", & tree_all_coords_of < 3, 2 >)
+  .method("get_all_death_rates", & Tree_3d::get_all_death_rates)
+  
+  .method("death_spline_at", & Tree_3d::get_death_spline_value)
+  .method("birth_inverse_rcdf_spline_at", & Tree_3d::get_birth_inverse_rcdf_spline_value)
+  
+  .method("make_event", & Tree_3d::make_event)
+  .method("run_events", & Tree_3d::run_events)
+  .method("run_for", & Tree_3d::run_for)
+  
+  .field_readonly("total_population", & Tree_3d::total_population)
+  .field_readonly("total_death_rate", & Tree_3d::total_death_rate)
+  .field_readonly("events", & Tree_3d::event_count)
+  .field_readonly("time", & Tree_3d::time)
+  
+  .field_readonly("realtime_limit", & Tree_3d::realtime_limit)
+  .field_readonly("realtime_limit_reached", & Tree_3d::realtime_limit_reached);
+}
+
+#endif
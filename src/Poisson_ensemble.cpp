@@ -0,0 +1,112 @@
+// [[Rcpp::depends(BH)]]
+// [[Rcpp::plugins(cpp11)]]
+#include <Rcpp.h>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "poisson_grid.h"
+#include "worker_pool.h"
+#include "task_queues.h"
+
+using namespace std;
+
+#ifndef POISSON_ENSEMBLE_H
+#define POISSON_ENSEMBLE_H
+
+//A run of run_grid_ensemble, the parameters of its Grid_nd < ndim > and what
+//the run recorded, or the error that stopped it from being built
+struct Ensemble_run {
+  int ndim;
+  Grid_params params;
+  vector < double > time;
+  vector < int > population;
+  vector < double > pattern[3];
+  bool realtime_limit_reached;
+  std::string error;
+
+  Ensemble_run(Rcpp::List params, int ndim): ndim(ndim), params(params, ndim), realtime_limit_reached(false) {}
+};
+
+//Builds the simulator of the run and runs epochs as run_simulation does, each
+//making as many events as there are specimens, until the population dies out
+//or the realtime limit is reached. The simulator only lives for the run.
+template < int Dim >
+static void run_epochs(Ensemble_run & run, int epochs) {
+  Grid_nd < Dim > sim(run.params);
+
+  run.time.push_back(sim.time);
+  run.population.push_back(sim.total_population);
+  for (int epoch = 0; epoch < epochs && sim.total_population > 0 && !sim.realtime_limit_reached; epoch++) {
+    sim.run_events(sim.total_population);
+    run.time.push_back(sim.time);
+    run.population.push_back(sim.total_population);
+  }
+  for (int axis = 0; axis < Dim; axis++)
+    run.pattern[axis] = sim.get_all_coords(axis);
+  run.realtime_limit_reached = sim.realtime_limit_reached;
+}
+
+//Runs poisson_1d, poisson_2d and poisson_3d simulators of the parameter lists
+//of initialize_simulator, of dimension ndims, for epochs each on threads
+//threads. Runs are dealt to the threads and stolen by those that run out, see
+//TaskQueues. The lists are read into plain C++ on the calling thread, and each
+//simulator is built just before its run and freed after it, so only as many
+//simulators as threads are held at once. The workers never call back into R.
+//Each simulator sweeps death rates on its own thread when it regrids, so the
+//threads of the ensemble are all it takes.
+static Rcpp::List run_grid_ensemble(Rcpp::List params, Rcpp::IntegerVector ndims, int epochs, int threads) {
+  if (params.size() != ndims.size())
+    Rcpp::stop("params and ndims differ in length");
+  if (threads < 1)
+    Rcpp::stop("threads must be positive");
+
+  vector < Ensemble_run > runs;
+  runs.reserve(params.size());
+  for (int i = 0; i < params.size(); i++) {
+    if (ndims[i] < 1 || ndims[i] > 3)
+      Rcpp::stop("ndim must be 1, 2 or 3");
+    runs.emplace_back(Rcpp::as < Rcpp::List > (params[i]), ndims[i]);
+    //A regrid must not start threads of its own on top of those of the ensemble
+    runs[i].params.threads = 1;
+  }
+
+  WorkerPool workers(std::min < int > (threads, std::max < int > (runs.size(), 1)));
+  TaskQueues queues(workers.Threads(), runs.size());
+  workers.Run(queues.Size(), [&](int queue) {
+    int task;
+    while (queues.Take(queue, task)) {
+      try {
+        if (runs[task].ndim == 1)      run_epochs < 1 > (runs[task], epochs);
+        else if (runs[task].ndim == 2) run_epochs < 2 > (runs[task], epochs);
+        else                           run_epochs < 3 > (runs[task], epochs);
+      } catch (const std::exception & e) {
+        runs[task].error = e.what();
+      }
+    }
+  });
+
+  for (int i = 0; i < static_cast < int > (runs.size()); i++) {
+    if (!runs[i].error.empty())
+      Rcpp::stop("Run " + std::to_string(i + 1) + ": " + runs[i].error);
+  }
+
+  Rcpp::List results(runs.size());
+  for (int i = 0; i < static_cast < int > (runs.size()); i++) {
+    Rcpp::List result;
+    result["time"] = runs[i].time;
+    result["population"] = runs[i].population;
+    for (int axis = 0; axis < runs[i].ndim; axis++)
+      result[std::string(1, "xyz"[axis])] = runs[i].pattern[axis];
+    result["realtime_limit_reached"] = runs[i].realtime_limit_reached;
+    results[i] = result;
+  }
+  return results;
+}
+
+RCPP_MODULE(poisson_ensemble_module) {
+  Rcpp::function("run_grid_ensemble", & run_grid_ensemble,
+                 "Runs grid simulators for a number of epochs each on a pool of threads");
+}
+
+#endif
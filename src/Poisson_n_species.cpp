@@ -21,9 +21,13 @@ RCPP_MODULE(poisson_1d_n_species_module)
   .field_readonly("dd", &Grid::dd)
   
   .field_readonly("seed", &Grid::seed)
+  .field_readonly("sampler", &Grid::sampler)
   .field_readonly("initial_density", &Grid::initial_density)
 
   .field_readonly("death_cutoff_r", &Grid::death_cutoff_r)
+  .field_readonly("death_kernel", &Grid::death_kernel)
+  .field_readonly("death_kernel_tolerance", &Grid::death_kernel_tolerance)
+  .field_readonly("death_kernel_max_error", &Grid::death_kernel_max_error)
 
   .field_readonly("cell_death_rates", &Grid::cell_death_rates)
   .field_readonly("cell_population", &Grid::cell_population)
@@ -8,10 +8,32 @@ using namespace Rcpp;
 
 RcppExport SEXP _rcpp_module_boot_poisson_1d_module();
 RcppExport SEXP _rcpp_module_boot_poisson_1d_n_species_module();
+RcppExport SEXP _rcpp_module_boot_poisson_1d_tree_module();
+RcppExport SEXP _rcpp_module_boot_poisson_2d_tree_module();
+RcppExport SEXP _rcpp_module_boot_poisson_3d_tree_module();
+RcppExport SEXP _rcpp_module_boot_poisson_1d_sparse_module();
+RcppExport SEXP _rcpp_module_boot_poisson_2d_sparse_module();
+RcppExport SEXP _rcpp_module_boot_poisson_3d_sparse_module();
+RcppExport SEXP _rcpp_module_boot_poisson_1d_parallel_module();
+RcppExport SEXP _rcpp_module_boot_poisson_2d_parallel_module();
+RcppExport SEXP _rcpp_module_boot_poisson_3d_parallel_module();
+RcppExport SEXP _rcpp_module_boot_poisson_2d_hybrid_module();
+RcppExport SEXP _rcpp_module_boot_poisson_ensemble_module();
 
 static const R_CallMethodDef CallEntries[] = {
     {"_rcpp_module_boot_poisson_1d_module", (DL_FUNC) &_rcpp_module_boot_poisson_1d_module, 0},
     {"_rcpp_module_boot_poisson_1d_n_species_module", (DL_FUNC) &_rcpp_module_boot_poisson_1d_n_species_module, 0},
+    {"_rcpp_module_boot_poisson_1d_tree_module", (DL_FUNC) &_rcpp_module_boot_poisson_1d_tree_module, 0},
+    {"_rcpp_module_boot_poisson_2d_tree_module", (DL_FUNC) &_rcpp_module_boot_poisson_2d_tree_module, 0},
+    {"_rcpp_module_boot_poisson_3d_tree_module", (DL_FUNC) &_rcpp_module_boot_poisson_3d_tree_module, 0},
+    {"_rcpp_module_boot_poisson_1d_sparse_module", (DL_FUNC) &_rcpp_module_boot_poisson_1d_sparse_module, 0},
+    {"_rcpp_module_boot_poisson_2d_sparse_module", (DL_FUNC) &_rcpp_module_boot_poisson_2d_sparse_module, 0},
+    {"_rcpp_module_boot_poisson_3d_sparse_module", (DL_FUNC) &_rcpp_module_boot_poisson_3d_sparse_module, 0},
+    {"_rcpp_module_boot_poisson_1d_parallel_module", (DL_FUNC) &_rcpp_module_boot_poisson_1d_parallel_module, 0},
+    {"_rcpp_module_boot_poisson_2d_parallel_module", (DL_FUNC) &_rcpp_module_boot_poisson_2d_parallel_module, 0},
+    {"_rcpp_module_boot_poisson_3d_parallel_module", (DL_FUNC) &_rcpp_module_boot_poisson_3d_parallel_module, 0},
+    {"_rcpp_module_boot_poisson_2d_hybrid_module", (DL_FUNC) &_rcpp_module_boot_poisson_2d_hybrid_module, 0},
+    {"_rcpp_module_boot_poisson_ensemble_module", (DL_FUNC) &_rcpp_module_boot_poisson_ensemble_module, 0},
     {NULL, NULL, 0}
 };
 
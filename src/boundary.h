@@ -0,0 +1,24 @@
+#ifndef BOUNDARY_H
+#define BOUNDARY_H
+
+//Where a coordinate that left the area ends up, false if the specimen is lost
+template < bool Periodic >
+struct Boundary;
+
+template < >
+struct Boundary < true > {
+  static bool place(double & coord, double area_length) {
+    if (coord < 0)           coord += area_length;
+    if (coord > area_length) coord -= area_length;
+    return true;
+  }
+};
+
+template < >
+struct Boundary < false > {
+  static bool place(double & coord, double area_length) {
+    return coord >= 0 && coord <= area_length;
+  }
+};
+
+#endif
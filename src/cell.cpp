@@ -1,21 +1,80 @@
 #include "cell.h"
 
-void Cell::SwapWithLast(int i) {
-  death_rates[i] = death_rates.back();
-  coords_x[i] = coords_x.back();
-  species[i] = species.back();
+Cell::Cell()
+  : Arena(nullptr)
+  , Index(0)
+{ }
+
+Cell::Cell(SpecimenArena<1>* arena, int index)
+  : Arena(arena)
+  , Index(index)
+{ }
+
+int Cell::Size() const {
+  return Arena->CellSize(Index);
+}
+
+DCoord Cell::Coord(int i) const {
+  return Arena->Coords(0, Index)[i];
+}
+
+double& Cell::DeathRate(int i) {
+  return Arena->DeathRates(Index)[i];
+}
+
+int Cell::Species(int i) const {
+  return Arena->Species(Index)[i];
 }
 
-void Cell::Pop() {
-  death_rates.pop_back();
-  coords_x.pop_back();
-  species.pop_back();
+void Cell::Remove(int i) {
+  int s = Species(i);
+  int p = species_position[i];
+  
+  // Close the gap in the species index first, so that slot i is free
+  int lastOfSpecies = species_slots[s].back();
+  species_slots[s][p] = lastOfSpecies;
+  species_position[lastOfSpecies] = p;
+  species_death_rates[s].SwapWithLast(p);
+  species_slots[s].pop_back();
+  species_death_rates[s].Pop();
+  
+  int last = Size() - 1;
+  if (i != last) {
+    species_slots[Species(last)][species_position[last]] = i;
+    species_position[i] = species_position[last];
+  }
+  species_position.pop_back();
+  
+  Arena->Remove(Index, i);
 }
 
 void Cell::Add(double deathRate, DCoord x, int species) {
-  death_rates.emplace_back(deathRate);
-  coords_x.emplace_back(std::move(x));
-  this->species.emplace_back(species);
+  if (species >= static_cast<int>(species_slots.size())) {
+    species_slots.resize(species + 1);
+    species_death_rates.resize(species + 1);
+  }
+  species_position.emplace_back(species_slots[species].size());
+  species_slots[species].emplace_back(Size());
+  species_death_rates[species].Push(deathRate);
+  
+  Arena->Add(Index, &x, deathRate, species);
+}
+
+void Cell::AddInteraction(int i, double interaction) {
+  double& deathRate = DeathRate(i);
+  deathRate += interaction;
+  species_death_rates[Species(i)].Set(species_position[i], deathRate);
+}
+
+double Cell::SpeciesDeathRate(int species) const {
+  if (species >= static_cast<int>(species_death_rates.size())) {
+    return 0;
+  }
+  return species_death_rates[species].Total();
+}
+
+int Cell::FindByDeathRate(int species, double u) const {
+  return species_slots[species][species_death_rates[species].Find(u)];
 }
 
 DCoord Cell::Ro(const Unit& a, const Unit& b) {
@@ -3,15 +3,36 @@
 
 #include "defines.h"
 #include "unit.h"
+#include "sum_tree.h"
+#include "specimen_arena.h"
 
 struct Cell {
-  std::vector<DCoord> coords_x;
-  std::vector<double> death_rates;
-  std::vector<int> species;
+  // Coordinates, death rates and species live in the grid-wide arena,
+  // this cell owns the range Index of it
+  SpecimenArena<1>* Arena;
+  int Index;
   
-  void SwapWithLast(int i);
-  void Pop();
+  // Members of each species are indexed densely so the dying unit of a given
+  // species is drawn from its own sum tree without scanning the cell.
+  // species_slots[s][p] is the arena slot of the p-th unit of species s,
+  // species_position is the inverse mapping.
+  MAT<int> species_slots;
+  std::vector<int> species_position;
+  VEC<SumTree> species_death_rates;
+  
+  Cell();
+  Cell(SpecimenArena<1>* arena, int index);
+  
+  int Size() const;
+  DCoord Coord(int i) const;
+  double& DeathRate(int i);
+  int Species(int i) const;
+  
+  void Remove(int i);
   void Add(double deathRate, DCoord x, int species);
+  void AddInteraction(int i, double interaction);
+  double SpeciesDeathRate(int species) const;
+  int FindByDeathRate(int species, double u) const;
   static DCoord Ro(const Unit& a, const Unit& b);
 };
 
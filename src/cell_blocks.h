@@ -0,0 +1,314 @@
+#ifndef CELL_BLOCKS
+#define CELL_BLOCKS
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "defines.h"
+#include "interaction_kernel.h"
+
+// Layout helpers shared by the grid engines. Cells are numbered in their
+// storage order: rowMajor gives the row-major position of each cell and
+// atRowMajor the cell at each position, both empty when cells are stored in
+// row-major order, as cell (i, j, k) at i + j * counts[0] + k * counts[0] * counts[1].
+
+// Neighbour cells of every cell: those that can hold a specimen within the
+// cutoff of some point of the cell, with the shifts that move their coordinates
+// next to it across a periodic boundary. The stencils of all cells are kept in
+// one array, built once for the grid.
+template <int Dim>
+class CellStencils {
+  VEC<int> _Begin;
+  VEC<int> _Self;
+  VEC<int> _Cells;
+  VEC<double> _Shift[Dim];
+
+public:
+  // Offsets of the cells of a stencil, from the smallest distance between two
+  // cells, with the last axis changing fastest. Only the corners of the
+  // (2 * cull + 1)^Dim cube are left out, so every offset is within cull along
+  // each axis.
+  static MAT<int> Offsets(const int* counts, const double* lengths, const int* cull, double cutoff);
+
+  void Build(const int* counts, const double* lengths, const int* cull, double cutoff, bool periodic,
+             const VEC<int>& rowMajor, const VEC<int>& atRowMajor);
+
+  // Entries of the stencil of the cell are [Begin(cell), End(cell)), Self(cell)
+  // is the entry of the cell itself
+  int Begin(int cell) const {
+    return _Begin[cell];
+  }
+  int End(int cell) const {
+    return _Begin[cell + 1];
+  }
+  int Self(int cell) const {
+    return _Self[cell];
+  }
+  int Cell(int entry) const {
+    return _Cells[entry];
+  }
+  double Shift(int axis, int entry) const {
+    return _Shift[axis][entry];
+  }
+
+  // Finds specimens within the cutoff of the point in the stencil of cell
+  // owner, leaving out slot skip of the owner itself. span(cell, x, first,
+  // last, coords) sets the slots [first, last) of a stencil cell worth scanning
+  // for a point at x along the first axis and the coordinates of the cell, or
+  // returns false to skip the cell. Slots and squared distances of the
+  // specimens found in the e-th entry of the stencil end at end[e] in slots
+  // and squaredDistances.
+  template <class Span>
+  void Collect(const InteractionKernel& scan, const double* point, int owner, int skip, double cutoffSquared,
+               Span span, VEC<int>& end, VEC<int>& slots, VEC<double>& squaredDistances) const;
+};
+
+// Cells split into blocks of at least 2 * cull + 1 cells per axis, an even
+// number of blocks along each split axis, coloured by the parity of their
+// position. Blocks of one colour are a whole block apart, so work on one that
+// reads and writes only within cull cells of it never meets work on another.
+template <int Dim>
+class CellBlocks {
+  int _Along[Dim];
+  MAT<int> _Cells;
+  MAT<int> _Colours;
+  VEC<int> _Block;
+  VEC<int> _Local;
+
+public:
+  CellBlocks();
+  // As many blocks as fit, then the axis with most blocks is halved until there
+  // are at most maxBlocks. rowMajor is as above.
+  CellBlocks(const int* counts, const int* cull, int maxBlocks, const VEC<int>& rowMajor);
+
+  int Count() const {
+    return _Cells.size();
+  }
+  int Along(int axis) const {
+    return _Along[axis];
+  }
+  // Cells of the block in storage order
+  const VEC<int>& Cells(int block) const {
+    return _Cells[block];
+  }
+  // Colours without blocks, along axes left unsplit, are left out
+  int ColourCount() const {
+    return _Colours.size();
+  }
+  const VEC<int>& Colour(int colour) const {
+    return _Colours[colour];
+  }
+  // Cell is Cells(BlockOf(cell))[LocalOf(cell)]
+  int BlockOf(int cell) const {
+    return _Block[cell];
+  }
+  int LocalOf(int cell) const {
+    return _Local[cell];
+  }
+};
+
+template <int Dim>
+MAT<int> CellStencils<Dim>::Offsets(const int* counts, const double* lengths, const int* cull, double cutoff) {
+  // Coordinates that round into a neighbouring cell may be closer than the cells are
+  const double slack = 1 + 1e-9;
+  MAT<int> offsets;
+  VEC<int> offset(Dim);
+  for (int axis = 0; axis < Dim; ++axis) {
+    offset[axis] = -cull[axis];
+  }
+
+  while (true) {
+    double gapSquared = 0;
+    for (int axis = 0; axis < Dim; ++axis) {
+      double gap = std::max(std::abs(offset[axis]) - 1, 0) * lengths[axis] / counts[axis];
+      gapSquared += gap * gap;
+    }
+    if (gapSquared <= cutoff * cutoff * slack) {
+      offsets.push_back(offset);
+    }
+
+    int axis = Dim - 1;
+    while (axis >= 0 && offset[axis] == cull[axis]) {
+      offset[axis] = -cull[axis];
+      --axis;
+    }
+    if (axis < 0) {
+      break;
+    }
+    ++offset[axis];
+  }
+  return offsets;
+}
+
+template <int Dim>
+void CellStencils<Dim>::Build(const int* counts, const double* lengths, const int* cull, double cutoff, bool periodic,
+                              const VEC<int>& rowMajor, const VEC<int>& atRowMajor) {
+  MAT<int> offsets = Offsets(counts, lengths, cull, cutoff);
+  int strides[Dim];
+  int total = 1;
+  for (int axis = 0; axis < Dim; ++axis) {
+    strides[axis] = total;
+    total *= counts[axis];
+  }
+
+  _Begin.assign(total + 1, 0);
+  _Self.assign(total, 0);
+  _Cells.clear();
+  _Cells.reserve(total * offsets.size());
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Shift[axis].clear();
+    _Shift[axis].reserve(total * offsets.size());
+  }
+
+  for (int cell = 0; cell < total; ++cell) {
+    _Begin[cell] = _Cells.size();
+    int position = rowMajor.empty() ? cell : rowMajor[cell];
+
+    for (const VEC<int>& offset : offsets) {
+      bool inside = true;
+      bool self = true;
+      int neighbour = 0;
+      for (int axis = 0; axis < Dim; ++axis) {
+        int n = position / strides[axis] % counts[axis] + offset[axis];
+        if (!periodic && (n < 0 || n >= counts[axis])) {
+          inside = false;
+        }
+        neighbour += (n % counts[axis] + counts[axis]) % counts[axis] * strides[axis];
+        self = self && offset[axis] == 0;
+      }
+      if (!inside) {
+        continue;
+      }
+
+      if (self) {
+        _Self[cell] = _Cells.size();
+      }
+      _Cells.push_back(atRowMajor.empty() ? neighbour : atRowMajor[neighbour]);
+      for (int axis = 0; axis < Dim; ++axis) {
+        int n = position / strides[axis] % counts[axis] + offset[axis];
+        int wrapped = (n % counts[axis] + counts[axis]) % counts[axis];
+        _Shift[axis].push_back((wrapped - n) / counts[axis] * lengths[axis]);
+      }
+    }
+  }
+  _Begin.back() = _Cells.size();
+}
+
+template <int Dim>
+template <class Span>
+void CellStencils<Dim>::Collect(const InteractionKernel& scan, const double* point, int owner, int skip, double cutoffSquared,
+                                Span span, VEC<int>& end, VEC<int>& slots, VEC<double>& squaredDistances) const {
+  // The point may be a slot of a cell the span moves
+  double here[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    here[axis] = point[axis];
+  }
+
+  int begin = Begin(owner);
+  if (static_cast<int>(end.size()) < End(owner) - begin) {
+    end.resize(End(owner) - begin);
+  }
+
+  int found = 0;
+  for (int s = begin; s < End(owner); ++s) {
+    int cell = Cell(s);
+    int first = 0;
+    int last = 0;
+    const double* coords[Dim];
+    if (!span(cell, here[0] + Shift(0, s), first, last, coords)) {
+      end[s - begin] = found;
+      continue;
+    }
+    int size = last - first;
+    if (static_cast<int>(slots.size()) < found + size + InteractionKernel::Padding) {
+      slots.resize(2 * (found + size + InteractionKernel::Padding));
+      squaredDistances.resize(2 * (found + size + InteractionKernel::Padding));
+    }
+
+    double shift[Dim];
+    for (int axis = 0; axis < Dim; ++axis) {
+      shift[axis] = Shift(axis, s);
+      coords[axis] += first;
+    }
+    int selfSkip = s == Self(owner) ? skip - first : -1;
+
+    int* cellSlots = slots.data() + found;
+    int count = scan.Scan<Dim>(here, coords, shift, size, cutoffSquared, selfSkip,
+                               cellSlots, squaredDistances.data() + found);
+    if (first > 0) {
+      for (int n = 0; n < count; ++n) {
+        cellSlots[n] += first;
+      }
+    }
+    found += count;
+    end[s - begin] = found;
+  }
+}
+
+template <int Dim>
+CellBlocks<Dim>::CellBlocks() {
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Along[axis] = 1;
+  }
+}
+
+template <int Dim>
+CellBlocks<Dim>::CellBlocks(const int* counts, const int* cull, int maxBlocks, const VEC<int>& rowMajor) {
+  int count = 1;
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Along[axis] = counts[axis] / (2 * cull[axis] + 1);
+    if (_Along[axis] % 2 == 1) {
+      --_Along[axis];
+    }
+    if (_Along[axis] < 2) {
+      _Along[axis] = 1;
+    }
+    count *= _Along[axis];
+  }
+  while (count > maxBlocks) {
+    int widest = std::max_element(_Along, _Along + Dim) - _Along;
+    count /= _Along[widest];
+    _Along[widest] = _Along[widest] / 4 * 2;
+    if (_Along[widest] < 2) {
+      _Along[widest] = 1;
+    }
+    count *= _Along[widest];
+  }
+
+  int strides[Dim];
+  int total = 1;
+  for (int axis = 0; axis < Dim; ++axis) {
+    strides[axis] = total;
+    total *= counts[axis];
+  }
+  _Cells.assign(count, VEC<int>());
+  _Block.assign(total, 0);
+  _Local.assign(total, 0);
+  for (int cell = 0; cell < total; ++cell) {
+    int position = rowMajor.empty() ? cell : rowMajor[cell];
+    int block = 0;
+    int blockStride = 1;
+    for (int axis = 0; axis < Dim; ++axis) {
+      block += position / strides[axis] % counts[axis] * _Along[axis] / counts[axis] * blockStride;
+      blockStride *= _Along[axis];
+    }
+    _Block[cell] = block;
+    _Local[cell] = _Cells[block].size();
+    _Cells[block].push_back(cell);
+  }
+
+  _Colours.assign(1 << Dim, VEC<int>());
+  for (int block = 0; block < count; ++block) {
+    int colour = 0;
+    int rest = block;
+    for (int axis = 0; axis < Dim; ++axis) {
+      colour |= rest % _Along[axis] % 2 << axis;
+      rest /= _Along[axis];
+    }
+    _Colours[colour].push_back(block);
+  }
+  _Colours.erase(std::remove_if(_Colours.begin(), _Colours.end(), [](const VEC<int>& blocks) { return blocks.empty(); }),
+                 _Colours.end());
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "cell_map.h"
+
+const uint64_t CellMap::Empty;
+
+CellMap::CellMap()
+  : Keys(16, Empty)
+  , Values(16, -1)
+  , Size(0)
+  , Mask(15)
+{ }
+
+// Finaliser of splitmix64, neighbouring cells end up far apart
+uint64_t CellMap::Hash(uint64_t key) {
+  key ^= key >> 30;
+  key *= 0xBF58476D1CE4E5B9ull;
+  key ^= key >> 27;
+  key *= 0x94D049BB133111EBull;
+  key ^= key >> 31;
+  return key;
+}
+
+void CellMap::Grow() {
+  VEC<uint64_t> keys(2 * Keys.size(), Empty);
+  VEC<int> values(2 * Keys.size(), -1);
+  keys.swap(Keys);
+  values.swap(Values);
+  Mask = Keys.size() - 1;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] == Empty) {
+      continue;
+    }
+    uint64_t at = Hash(keys[i]) & Mask;
+    while (Keys[at] != Empty) {
+      at = (at + 1) & Mask;
+    }
+    Keys[at] = keys[i];
+    Values[at] = values[i];
+  }
+}
+
+int CellMap::Find(uint64_t key) const {
+  for (uint64_t at = Hash(key) & Mask; Keys[at] != Empty; at = (at + 1) & Mask) {
+    if (Keys[at] == key) {
+      return Values[at];
+    }
+  }
+  return -1;
+}
+
+void CellMap::Insert(uint64_t key, int value) {
+  assert(key != Empty && Find(key) == -1);
+  if (2 * (Size + 1) > static_cast<int>(Keys.size())) {
+    Grow();
+  }
+  uint64_t at = Hash(key) & Mask;
+  while (Keys[at] != Empty) {
+    at = (at + 1) & Mask;
+  }
+  Keys[at] = key;
+  Values[at] = value;
+  ++Size;
+}
+
+void CellMap::Set(uint64_t key, int value) {
+  uint64_t at = Hash(key) & Mask;
+  while (Keys[at] != key) {
+    assert(Keys[at] != Empty);
+    at = (at + 1) & Mask;
+  }
+  Values[at] = value;
+}
+
+void CellMap::Erase(uint64_t key) {
+  uint64_t hole = Hash(key) & Mask;
+  while (Keys[hole] != key) {
+    assert(Keys[hole] != Empty);
+    hole = (hole + 1) & Mask;
+  }
+  // Entries after the hole move into it unless their home slot lies
+  // cyclically between the hole and where they are
+  for (uint64_t at = (hole + 1) & Mask; Keys[at] != Empty; at = (at + 1) & Mask) {
+    uint64_t home = Hash(Keys[at]) & Mask;
+    if (((at - home) & Mask) >= ((at - hole) & Mask)) {
+      Keys[hole] = Keys[at];
+      Values[hole] = Values[at];
+      hole = at;
+    }
+  }
+  Keys[hole] = Empty;
+  Values[hole] = -1;
+  --Size;
+}
+
+int CellMap::Count() const {
+  return Size;
+}
+
+int CellMap::Capacity() const {
+  return Keys.size();
+}
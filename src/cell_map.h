@@ -0,0 +1,38 @@
+#ifndef CELL_MAP
+#define CELL_MAP
+
+#include <cstdint>
+
+#include "defines.h"
+
+// Open addressing hash map from packed cell coordinates to a dense index.
+// Probing is linear and removal shifts the entries after the removed one
+// back, so there are no tombstones and lookups stay short however many
+// cells come and go. The table is kept at most half full.
+class CellMap {
+  static const uint64_t Empty = ~static_cast<uint64_t>(0);
+
+  VEC<uint64_t> Keys;
+  VEC<int> Values;
+  int Size;
+  uint64_t Mask;
+
+  static uint64_t Hash(uint64_t key);
+  void Grow();
+
+public:
+  CellMap();
+
+  // Value of the key, -1 if it is absent
+  int Find(uint64_t key) const;
+  // The key is expected absent
+  void Insert(uint64_t key, int value);
+  // The key is expected present
+  void Set(uint64_t key, int value);
+  void Erase(uint64_t key);
+
+  int Count() const;
+  int Capacity() const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "cell_order.h"
+
+// Bits of the index along an axis are interleaved, the top bit of x first
+static uint64_t MortonKey(const uint32_t* index, int dim, int bits) {
+  uint64_t key = 0;
+  for (int bit = bits - 1; bit >= 0; --bit) {
+    for (int axis = 0; axis < dim; ++axis) {
+      key = key << 1 | (index[axis] >> bit & 1);
+    }
+  }
+  return key;
+}
+
+// Position along the Hilbert curve, after J. Skilling, "Programming the
+// Hilbert curve", AIP Conf. Proc. 707 (2004). The index is turned into the
+// transposed form of the key, which interleaves into the key like a Morton index.
+static uint64_t HilbertKey(const uint32_t* index, int dim, int bits) {
+  uint32_t x[3];
+  std::copy(index, index + dim, x);
+
+  for (uint32_t q = 1u << (bits - 1); q > 1; q >>= 1) {
+    uint32_t p = q - 1;
+    for (int axis = 0; axis < dim; ++axis) {
+      if (x[axis] & q) {
+        x[0] ^= p;
+      } else {
+        uint32_t t = (x[0] ^ x[axis]) & p;
+        x[0] ^= t;
+        x[axis] ^= t;
+      }
+    }
+  }
+  for (int axis = 1; axis < dim; ++axis) {
+    x[axis] ^= x[axis - 1];
+  }
+  uint32_t t = 0;
+  for (uint32_t q = 1u << (bits - 1); q > 1; q >>= 1) {
+    if (x[dim - 1] & q) {
+      t ^= q - 1;
+    }
+  }
+  for (int axis = 0; axis < dim; ++axis) {
+    x[axis] ^= t;
+  }
+  return MortonKey(x, dim, bits);
+}
+
+bool CellOrder::IsKnownKind(const std::string& kind) {
+  return kind == "row_major" || kind == "morton" || kind == "hilbert";
+}
+
+VEC<int> CellOrder::RowMajorIndices(const std::string& kind, const int* counts, int dim) {
+  assert(IsKnownKind(kind) && dim >= 1 && dim <= 3);
+  int total = 1, bits = 1;
+  for (int axis = 0; axis < dim; ++axis) {
+    total *= counts[axis];
+    while ((1 << bits) < counts[axis]) {
+      ++bits;
+    }
+  }
+  VEC<int> indices(total);
+  for (int cell = 0; cell < total; ++cell) {
+    indices[cell] = cell;
+  }
+  if (kind == "row_major" || dim == 1) {
+    return indices;
+  }
+
+  VEC<uint64_t> keys(total);
+  for (int cell = 0; cell < total; ++cell) {
+    uint32_t index[3];
+    for (int axis = 0, rest = cell; axis < dim; ++axis) {
+      index[axis] = rest % counts[axis];
+      rest /= counts[axis];
+    }
+    keys[cell] = kind == "morton" ? MortonKey(index, dim, bits) : HilbertKey(index, dim, bits);
+  }
+  std::sort(indices.begin(), indices.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+  return indices;
+}
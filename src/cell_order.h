@@ -0,0 +1,25 @@
+#ifndef CELL_ORDER
+#define CELL_ORDER
+
+#include <string>
+
+#include "defines.h"
+
+// Order the cells of a grid are stored in. It is picked per simulator with
+// the "cell_order" parameter:
+//   "row_major"  x changes fastest, then y, then z (default)
+//   "morton"     Z-order curve
+//   "hilbert"    Hilbert curve
+// Along a curve, cells near in space are mostly near in memory along every
+// axis, not only along x. Grids of any shape are ordered by the curve over
+// the smallest power of two cube around them, skipping the cells outside.
+class CellOrder {
+public:
+  static bool IsKnownKind(const std::string& kind);
+
+  // Row-major indices of the cells of a grid with counts[axis] cells along
+  // each of dim axes, in storage order
+  static VEC<int> RowMajorIndices(const std::string& kind, const int* counts, int dim);
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include <cmath>
+
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "composition_rejection.h"
+
+CompositionRejection::CompositionRejection()
+  : Members(BinCount)
+  , BinTotals(BinCount, 0)
+  , LowestBin(BinCount)
+  , HighestBin(-1)
+  , UpdatesSinceResum(0)
+{ }
+
+CompositionRejection::CompositionRejection(int size)
+  : CompositionRejection()
+{
+  Resize(size);
+}
+
+int CompositionRejection::BinOf(double weight) {
+  if (weight <= 0) {
+    return -1;
+  }
+  int exponent;
+  std::frexp(weight, &exponent);
+  assert(exponent <= MaxExponent);
+  // Anything below 2^MinExponent shares the lowest bin, it is still bounded
+  // by that bin's ceiling so the rejection step stays exact.
+  return std::max(exponent, MinExponent) - MinExponent;
+}
+
+void CompositionRejection::Insert(int i, int bin) {
+  Bin[i] = bin;
+  if (bin < 0) {
+    return;
+  }
+  Position[i] = Members[bin].size();
+  Members[bin].push_back(i);
+  BinTotals[bin] += Weights[i];
+  LowestBin = std::min(LowestBin, bin);
+  HighestBin = std::max(HighestBin, bin);
+}
+
+void CompositionRejection::Erase(int i) {
+  int bin = Bin[i];
+  if (bin < 0) {
+    return;
+  }
+  int last = Members[bin].back();
+  Members[bin][Position[i]] = last;
+  Position[last] = Position[i];
+  Members[bin].pop_back();
+  BinTotals[bin] -= Weights[i];
+  
+  if (Members[bin].empty()) {
+    BinTotals[bin] = 0;
+    while (HighestBin >= 0 && Members[HighestBin].empty()) {
+      --HighestBin;
+    }
+    while (LowestBin < BinCount && Members[LowestBin].empty()) {
+      ++LowestBin;
+    }
+  }
+}
+
+void CompositionRejection::Resum() {
+  for (int bin = LowestBin; bin <= HighestBin; ++bin) {
+    double total = 0;
+    for (int i : Members[bin]) {
+      total += Weights[i];
+    }
+    BinTotals[bin] = total;
+  }
+  UpdatesSinceResum = 0;
+}
+
+void CompositionRejection::Resize(int size) {
+  Build(VEC<double>(size, 0));
+}
+
+void CompositionRejection::Build(const VEC<double>& weights) {
+  for (auto &members : Members) {
+    members.clear();
+  }
+  BinTotals.assign(BinCount, 0);
+  LowestBin = BinCount;
+  HighestBin = -1;
+  
+  Weights.assign(weights.size(), 0);
+  Bin.assign(weights.size(), -1);
+  Position.assign(weights.size(), 0);
+  for (size_t i = 0; i < weights.size(); ++i) {
+    Weights[i] = weights[i] < 0 ? 0 : weights[i];
+    Insert(i, BinOf(Weights[i]));
+  }
+  Resum();
+}
+
+void CompositionRejection::Set(int i, double weight) {
+  if (weight < 0) {
+    weight = 0;
+  }
+  int bin = BinOf(weight);
+  if (bin == Bin[i]) {
+    if (bin >= 0) {
+      BinTotals[bin] += weight - Weights[i];
+    }
+    Weights[i] = weight;
+  } else {
+    Erase(i);
+    Weights[i] = weight;
+    Insert(i, bin);
+  }
+  
+  if (++UpdatesSinceResum > Count()) {
+    Resum();
+  }
+}
+
+double CompositionRejection::Get(int i) const {
+  return Weights[i];
+}
+
+double CompositionRejection::Total() const {
+  double total = 0;
+  for (int bin = LowestBin; bin <= HighestBin; ++bin) {
+    total += BinTotals[bin];
+  }
+  return total;
+}
+
+int CompositionRejection::Count() const {
+  return Weights.size();
+}
+
+int CompositionRejection::Sample(boost::random::lagged_fibonacci2281& rng) const {
+  assert(HighestBin >= 0);
+  double u = boost::random::uniform_01<>()(rng) * Total();
+  
+  // Heaviest bins first, they hold most of the mass
+  int bin = HighestBin;
+  for (; bin > LowestBin; --bin) {
+    if (u < BinTotals[bin]) {
+      break;
+    }
+    u -= BinTotals[bin];
+  }
+  
+  const VEC<int> &members = Members[bin];
+  double ceiling = std::ldexp(1.0, bin + MinExponent);
+  for (;;) {
+    int i = members[
+      boost::random::uniform_int_distribution<>(0, members.size() - 1)(rng)
+    ];
+    if (boost::random::uniform_01<>()(rng) * ceiling < Weights[i]) {
+      return i;
+    }
+  }
+}
@@ -0,0 +1,51 @@
+#ifndef COMPOSITION_REJECTION
+#define COMPOSITION_REJECTION
+
+#include <boost/random/lagged_fibonacci.hpp>
+
+#include "defines.h"
+
+// Weighted choice by composition-rejection. Weights are grouped into bins
+// [2^(e-1), 2^e), a bin is chosen in proportion to its total, then a uniform
+// member is accepted with probability weight / 2^e (at least 1/2). The cost
+// of a draw depends on the number of occupied bins, not on the number of
+// weights, and the result is exact.
+class CompositionRejection {
+  static const int MinExponent = -126;
+  static const int MaxExponent = 128;
+  static const int BinCount = MaxExponent - MinExponent + 1;
+  
+  VEC<double> Weights;
+  VEC<int> Bin;
+  VEC<int> Position;
+  
+  MAT<int> Members;
+  VEC<double> BinTotals;
+  int LowestBin, HighestBin;
+  
+  // Bin totals are kept incrementally and resummed once per Count() updates
+  // so that rounding does not accumulate.
+  int UpdatesSinceResum;
+  
+  static int BinOf(double weight);
+  void Insert(int i, int bin);
+  void Erase(int i);
+  void Resum();
+
+public:
+  CompositionRejection();
+  explicit CompositionRejection(int size);
+  
+  void Resize(int size);
+  void Build(const VEC<double>& weights);
+  
+  void Set(int i, double weight);
+  double Get(int i) const;
+  
+  double Total() const;
+  int Count() const;
+  
+  int Sample(boost::random::lagged_fibonacci2281& rng) const;
+};
+
+#endif
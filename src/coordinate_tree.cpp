@@ -0,0 +1,161 @@
+#include "coordinate_tree.h"
+
+const int CoordinateTree::Nil;
+
+CoordinateTree::CoordinateTree()
+  : Root(Nil)
+  , PriorityState(0x9E3779B97F4A7C15ull)
+{ }
+
+void CoordinateTree::Clear() {
+  Root = Nil;
+  Nodes.clear();
+  Free.clear();
+}
+
+int CoordinateTree::Insert(double key, double rate) {
+  if (rate < 0) {
+    rate = 0;
+  }
+  // Priorities come from a generator of the tree's own, so the shape never
+  // depends on the simulation stream
+  PriorityState ^= PriorityState << 13;
+  PriorityState ^= PriorityState >> 7;
+  PriorityState ^= PriorityState << 17;
+
+  Node fresh = {key, rate, rate, PriorityState, 1, Nil, Nil};
+  int node;
+  if (Free.empty()) {
+    node = Nodes.size();
+    Nodes.push_back(fresh);
+  } else {
+    node = Free.back();
+    Free.pop_back();
+    Nodes[node] = fresh;
+  }
+  Root = InsertAt(Root, node);
+  return node;
+}
+
+int CoordinateTree::InsertAt(int root, int node) {
+  if (root == Nil) {
+    return node;
+  }
+  if (Before(node, root)) {
+    Nodes[root].Left = InsertAt(Nodes[root].Left, node);
+    if (Nodes[Nodes[root].Left].Priority > Nodes[root].Priority) {
+      int top = Nodes[root].Left;
+      Nodes[root].Left = Nodes[top].Right;
+      Nodes[top].Right = root;
+      Pull(root);
+      root = top;
+    }
+  } else {
+    Nodes[root].Right = InsertAt(Nodes[root].Right, node);
+    if (Nodes[Nodes[root].Right].Priority > Nodes[root].Priority) {
+      int top = Nodes[root].Right;
+      Nodes[root].Right = Nodes[top].Left;
+      Nodes[top].Left = root;
+      Pull(root);
+      root = top;
+    }
+  }
+  Pull(root);
+  return root;
+}
+
+void CoordinateTree::Erase(int node) {
+  assert(node >= 0 && node < static_cast<int>(Nodes.size()));
+  Root = EraseAt(Root, node);
+  Free.push_back(node);
+}
+
+int CoordinateTree::EraseAt(int root, int node) {
+  assert(root != Nil);
+  if (root == node) {
+    return Merge(Nodes[root].Left, Nodes[root].Right);
+  }
+  if (Before(node, root)) {
+    Nodes[root].Left = EraseAt(Nodes[root].Left, node);
+  } else {
+    Nodes[root].Right = EraseAt(Nodes[root].Right, node);
+  }
+  Pull(root);
+  return root;
+}
+
+int CoordinateTree::Merge(int left, int right) {
+  if (left == Nil) {
+    return right;
+  }
+  if (right == Nil) {
+    return left;
+  }
+  if (Nodes[left].Priority > Nodes[right].Priority) {
+    Nodes[left].Right = Merge(Nodes[left].Right, right);
+    Pull(left);
+    return left;
+  }
+  Nodes[right].Left = Merge(left, Nodes[right].Left);
+  Pull(right);
+  return right;
+}
+
+double CoordinateTree::Key(int node) const {
+  return Nodes[node].Key;
+}
+
+double CoordinateTree::Rate(int node) const {
+  return Nodes[node].Rate;
+}
+
+double CoordinateTree::Total() const {
+  return SumOf(Root);
+}
+
+int CoordinateTree::Count() const {
+  return CountOf(Root);
+}
+
+int CoordinateTree::Find(double u) const {
+  assert(Root != Nil);
+  int node = Root;
+  // Last point with a positive rate passed on the right, the answer if u
+  // runs past the total through rounding
+  int last = Nil;
+  while (true) {
+    double left = SumOf(Nodes[node].Left);
+    if (u < left) {
+      node = Nodes[node].Left;
+      continue;
+    }
+    u -= left;
+    if (Nodes[node].Rate > 0) {
+      if (u < Nodes[node].Rate) {
+        return node;
+      }
+      last = node;
+    }
+    u -= Nodes[node].Rate;
+    if (Nodes[node].Right == Nil || Nodes[Nodes[node].Right].Sum <= 0) {
+      return last == Nil ? node : last;
+    }
+    node = Nodes[node].Right;
+  }
+}
+
+int CoordinateTree::Select(int rank) const {
+  assert(rank >= 0 && rank < Count());
+  int node = Root;
+  while (true) {
+    int left = CountOf(Nodes[node].Left);
+    if (rank < left) {
+      node = Nodes[node].Left;
+    } else if (rank == left) {
+      return node;
+    } else {
+      rank -= left + 1;
+      node = Nodes[node].Right;
+    }
+  }
+}
@@ -0,0 +1,121 @@
+#ifndef COORDINATE_TREE
+#define COORDINATE_TREE
+
+#include <cstdint>
+
+#include "defines.h"
+
+// Balanced search tree of points on a line, each with a non-negative rate.
+// It is a treap keyed by coordinate, ties broken by handle, and every node
+// holds the count and rate sum of its subtree, so insertion, removal, a
+// rate weighted or uniform draw and finding the k-th point are all
+// O(log n) expected. Handles stay valid until their point is erased and
+// are reused afterwards.
+class CoordinateTree {
+  static const int Nil = -1;
+
+  // Fields of a node are kept together, as a search reads all of them
+  struct Node {
+    double Key;
+    double Rate;
+    double Sum;
+    uint64_t Priority;
+    int Count;
+    int Left;
+    int Right;
+  };
+
+  int Root;
+  uint64_t PriorityState;
+  VEC<Node> Nodes;
+  VEC<int> Free;
+
+  double SumOf(int node) const {
+    return node == Nil ? 0 : Nodes[node].Sum;
+  }
+  int CountOf(int node) const {
+    return node == Nil ? 0 : Nodes[node].Count;
+  }
+  bool Before(int a, int b) const {
+    return Nodes[a].Key < Nodes[b].Key || (Nodes[a].Key == Nodes[b].Key && a < b);
+  }
+  void Pull(int node) {
+    Node& n = Nodes[node];
+    n.Sum = SumOf(n.Left) + n.Rate + SumOf(n.Right);
+    n.Count = CountOf(n.Left) + 1 + CountOf(n.Right);
+  }
+
+  int InsertAt(int root, int node);
+  int EraseAt(int root, int node);
+  int Merge(int left, int right);
+
+  template <class F>
+  void UpdateAt(int root, double from, double to, F& update) {
+    if (root == Nil) {
+      return;
+    }
+    Node& node = Nodes[root];
+    // Equal keys may sit on either side of a node
+    if (from <= node.Key) {
+      UpdateAt(node.Left, from, to, update);
+    }
+    if (from <= node.Key && node.Key <= to) {
+      node.Rate = update(node.Key, node.Rate);
+      if (node.Rate < 0) {
+        node.Rate = 0;
+      }
+    }
+    if (node.Key <= to) {
+      UpdateAt(node.Right, from, to, update);
+    }
+    Pull(root);
+  }
+
+  template <class F>
+  void VisitAt(int root, F& visit) const {
+    if (root == Nil) {
+      return;
+    }
+    VisitAt(Nodes[root].Left, visit);
+    visit(Nodes[root].Key, Nodes[root].Rate);
+    VisitAt(Nodes[root].Right, visit);
+  }
+
+public:
+  CoordinateTree();
+
+  void Clear();
+
+  // Returns the handle of the new point
+  int Insert(double key, double rate);
+  void Erase(int node);
+
+  double Key(int node) const;
+  double Rate(int node) const;
+
+  // Replaces the rate of every point with key in [from, to] by
+  // update(key, rate), in increasing key order. Sums are restored on the way
+  // back, so it is O(log n + points updated) rather than O(log n) per point.
+  template <class F>
+  void Update(double from, double to, F update) {
+    UpdateAt(Root, from, to, update);
+  }
+
+  // Calls visit(key, rate) for every point in increasing key order
+  template <class F>
+  void Visit(F visit) const {
+    VisitAt(Root, visit);
+  }
+
+  double Total() const;
+  int Count() const;
+
+  // Handle of the point whose cumulative rate interval contains u, u is
+  // expected in [0, Total()). Zero-rate points are not returned while any
+  // rate is positive.
+  int Find(double u) const;
+  // Handle of the point with rank points before it in key order
+  int Select(int rank) const;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef DISPERSAL_H
+#define DISPERSAL_H
+
+#include <math.h>
+#include <boost/random.hpp>
+#include <boost/math/interpolators/cardinal_cubic_b_spline.hpp>
+
+//Draws where an offspring of a parent at the point at lands, before the area
+//boundary is applied. The distance is drawn from the birth inverse radial cdf,
+//to either side in 1d and in a direction uniformly distributed on the sphere
+//in 2d and 3d. All engines draw offspring here, so they share one birth kernel.
+template < int Dim, class Rng >
+void draw_offspring(const boost::math::interpolators::cardinal_cubic_b_spline < double > & birth_inverse_rcdf_spline,
+                    Rng & rng, const double * at, double * point) {
+  if (Dim == 1) {
+    point[0] = at[0] +
+      birth_inverse_rcdf_spline(boost::random::uniform_01 < > ()(rng)) * (boost::random::bernoulli_distribution < > (0.5)(rng) * 2 - 1);
+    return;
+  }
+  // Generates a direction uniformly distributed on a sphere
+  // See https://stackoverflow.com/questions/38038776/computationally-picking-a-random-point-on-a-n-sphere
+  double normal[Dim];
+  double normal_length = 0;
+  for (int axis = 0; axis < Dim; axis++) {
+    normal[axis] = boost::random::normal_distribution < > ()(rng);
+    normal_length += normal[axis] * normal[axis];
+  }
+  normal_length = sqrt(normal_length);
+
+  // Uses radius distribution to create spherical simmetrical function
+  double r_displacement = birth_inverse_rcdf_spline(boost::random::uniform_01 < > ()(rng));
+
+  for (int axis = 0; axis < Dim; axis++)
+    point[axis] = at[axis] + normal[axis] / normal_length * r_displacement;
+}
+
+#endif
@@ -22,16 +22,12 @@ void Grid::chek() {
 }
 
 int Grid::get_all_population() {
-  int res = 0;
-  for (auto i : RangeSpecies()) {
-    res += total_population[i];
-  }
-  return res;
+  return all_population;
 }
 
 VEC<DCoord> Grid::get_coords_at_cell(int i)
 {
-  return cells[i].coords_x;
+  return VEC<DCoord>(arena.Coords(0, i), arena.Coords(0, i) + arena.CellSize(i));
 }
 
 Range Grid::RangeSpecies() {
@@ -43,6 +39,7 @@ UnitIterating Grid::RangeAllUnits() {
     cells,
     cell_death_rates,
     cell_population,
+    occupied_cells,
     0,
     cell_count_x
   );
@@ -53,14 +50,32 @@ UnitIterating Grid::RangeLocalUnits(int i) {
     cells,
     cell_death_rates,
     cell_population,
-    std::max(0, i - cull_x),
-    std::min(cell_count_x, i + cull_x + 1)
+    occupied_cells,
+    local_begin[i],
+    local_end[i]
   );
 }
 
+void Grid::BuildLocalRanges() {
+  local_begin = VEC<int>(cell_count_x);
+  local_end = VEC<int>(cell_count_x);
+  for (auto i : Range(cell_count_x)) {
+    local_begin[i] = std::max(0, i - cull_x);
+    local_end[i] = std::min(cell_count_x, i + cull_x + 1);
+  }
+}
+
 double Grid::CalcInteraction(const Unit& cell1, const Unit& cell2) {
   double distance = Cell::Ro(cell1, cell2);
   
+  if (death_tabulated) {
+    const KernelTable &table = death_kernel_table[cell1.Species()][cell2.Species()];
+    double squared_distance = distance * distance;
+    if (squared_distance > table.CutoffSquared())
+      return -1; //Too far to interact
+    return table(squared_distance);
+  }
+  
   if (distance > death_cutoff_r[cell1.Species()][cell2.Species()])
     return -1; //Too far to interact
   
@@ -71,10 +86,10 @@ double Grid::CalcInteraction(const Unit& cell1, const Unit& cell2) {
 VEC<DCoord> Grid::get_all_coords()
 {
   VEC<DCoord> result;
-  for (auto cell : cells)
+  result.reserve(all_population);
+  for (auto i : Range(arena.CellCount()))
   {
-    if (cell.coords_x.size() != 0)
-      result.insert(result.end(), cell.coords_x.begin(), cell.coords_x.end());
+    result.insert(result.end(), arena.Coords(0, i), arena.Coords(0, i) + arena.CellSize(i));
   }
   return result;
 }
@@ -82,9 +97,12 @@ VEC<DCoord> Grid::get_all_coords()
 VEC<DCoord> Grid::GetAllCoordsForSpecies(int species) {
   VEC<DCoord> res;
   res.reserve(total_population[species]);
-  for (auto unit : RangeAllUnits()) {
-    if (unit.Species() == species) {
-      res.emplace_back(unit.Coord());
+  const OccupancyBitmap &occupied = occupied_species_cells[species];
+  for (int i = occupied.Next(0, cell_count_x); i < cell_count_x; i = occupied.Next(i + 1, cell_count_x)) {
+    for (auto k : Range(cells[i].Size())) {
+      if (cells[i].Species(k) == species) {
+        res.emplace_back(cells[i].Coord(k));
+      }
     }
   }
   return res;
@@ -93,17 +111,33 @@ VEC<DCoord> Grid::GetAllCoordsForSpecies(int species) {
 VEC<double> Grid::get_all_death_rates()
 {
   VEC<double> result;
-  for (auto cell : cells)
+  result.reserve(all_population);
+  for (auto i : Range(arena.CellCount()))
   {
-    if (cell.coords_x.size() != 0)
-      result.insert(result.end(), cell.death_rates.begin(), cell.death_rates.end());
+    result.insert(result.end(), arena.DeathRates(i), arena.DeathRates(i) + arena.CellSize(i));
   }
   return result;
 }
 
+void Grid::RefreshCellDeathRate(Unit& unit) {
+  cell_death_rate_samplers[unit.Species()].Set(unit.CellNum(), unit.CellDeathRate());
+}
+
+void Grid::RefreshSpeciesRates(int s) {
+  if (total_population[s] > 0) {
+    species_rates.Set(2 * s + 0, total_death_rate[s]);
+    species_rates.Set(2 * s + 1, total_population[s] * b[s]);
+  } else {
+    species_rates.Set(2 * s + 0, 0);
+    species_rates.Set(2 * s + 1, 0);
+  }
+}
+
 void Grid::AddDeathRate(Unit& unit) {
   unit.CellDeathRate() += d[unit.Species()];
   total_death_rate[unit.Species()] += d[unit.Species()];
+  RefreshCellDeathRate(unit);
+  RefreshSpeciesRates(unit.Species());
 }
 
 void Grid::SubDeathRate(Unit& unit) {
@@ -112,6 +146,8 @@ void Grid::SubDeathRate(Unit& unit) {
   if (unit.CellDeathRate() < 1e-10) {
     unit.CellDeathRate() = 0;
   }
+  RefreshCellDeathRate(unit);
+  RefreshSpeciesRates(unit.Species());
 }
 
 void Grid::Initialize_death_rates() {
@@ -120,6 +156,15 @@ void Grid::Initialize_death_rates() {
   }
   cell_death_rates = VEC<VEC<double>>(species_count, VEC<double>(cells.size(), 0));
   cell_population = VEC<VEC<int>>(species_count, VEC<int>(cell_count_x, 0));
+  occupied_cells = OccupancyBitmap(cell_count_x);
+  occupied_species_cells = VEC<OccupancyBitmap>(species_count, OccupancyBitmap(cell_count_x));
+  specimens = SpecimenIndex(species_count, cells.size());
+  species_rates = SumTree(2 * species_count);
+  all_population = 0;
+  cell_death_rate_samplers = VEC<RateSampler>(species_count, RateSampler(sampler));
+  for (auto &cellSampler : cell_death_rate_samplers) {
+    cellSampler.Resize(cells.size());
+  }
   
   for (auto s : RangeSpecies()) {
     double x_coord;
@@ -128,6 +173,7 @@ void Grid::Initialize_death_rates() {
       
       auto i = GetNewCellIndex(x_coord);
       cell_at(i).Add(d[s], x_coord, s);
+      specimens.Add(i, s);
       auto unit = GetLastUnit(i);
       
       AddDeathRate(unit);
@@ -135,30 +181,53 @@ void Grid::Initialize_death_rates() {
       chek();
     }
   }
+  // Lay cells out in order before the sweep
+  arena.Repack();
   
-  for (auto cell1 : RangeAllUnits()) {
-    for (auto cell2 : RangeLocalUnits(cell1.CellNum())) {
-      if (cell1 == cell2)
-        continue; // same speciment
-      
-      double interaction = CalcInteraction(cell1, cell2);
-      if (interaction < 0) {
-        continue;
+  // Each unordered pair is visited once, from the earlier cell or slot.
+  // Kernels and cutoffs of different species need not be symmetric, so then
+  // each side gets its own interaction.
+  for (int i = occupied_cells.Next(0, cell_count_x); i < cell_count_x; i = occupied_cells.Next(i + 1, cell_count_x)) {
+    for (int j = i; j < local_end[i]; j = occupied_cells.Next(j + 1, local_end[i])) {
+      for (auto k : Range(cells[i].Size())) {
+        Unit unit1 = GetUnit(i, k);
+        for (auto l : Range(i == j ? k + 1 : 0, cells[j].Size())) {
+          Unit unit2 = GetUnit(j, l);
+          
+          double interaction = CalcInteraction(unit1, unit2);
+          if (interaction >= 0) {
+            unit1.AddInteraction(interaction);
+          }
+          if (unit1.Species() != unit2.Species()) {
+            interaction = CalcInteraction(unit2, unit1);
+          }
+          if (interaction >= 0) {
+            unit2.AddInteraction(interaction);
+          }
+        }
       }
-      if (std::isnan(interaction)) {
-        abort();
-      }
-      
-      AddInteraction(cell1, interaction);
     }
   }
+  
+  // Cell and species rates are summed once all pairs are in
+  for (auto s : RangeSpecies()) {
+    total_death_rate[s] = 0;
+    for (auto i : Range(cell_count_x)) {
+      cell_death_rates[s][i] = cells[i].SpeciesDeathRate(s);
+      total_death_rate[s] += cell_death_rates[s][i];
+    }
+    cell_death_rate_samplers[s].Build(cell_death_rates[s]);
+    RefreshSpeciesRates(s);
+  }
   chek();
 }
 
 void Grid::AddInteraction(Unit& cell, double interaction) {
-  cell.DeathRate() += interaction;
+  cell.AddInteraction(interaction);
   cell.CellDeathRate() += interaction;
   total_death_rate[cell.Species()] += interaction;
+  RefreshCellDeathRate(cell);
+  RefreshSpeciesRates(cell.Species());
 }
 
 Unit Grid::GetUnit(int i, int j) {
@@ -166,7 +235,7 @@ Unit Grid::GetUnit(int i, int j) {
 }
 
 double Grid::GetRandomDeathIndex(int s) {
-  return boost::random::discrete_distribution<>(cell_death_rates[s])(rng);
+  return cell_death_rate_samplers[s].Sample(rng);
 }
 
 void Grid::kill_random(int s)
@@ -181,27 +250,16 @@ void Grid::kill_random(int s)
   
   auto &death_cell = cells[cellDeathIndex];
   
-  VEC<double> tmp_vec;
-  VEC<size_t> translate;
-  tmp_vec.reserve(death_cell.death_rates.size());
-  translate.reserve(death_cell.death_rates.size());
-  for (size_t i = 0; i < death_cell.death_rates.size(); ++i) {
-    if (death_cell.species[i] == s) {
-      tmp_vec.push_back(death_cell.death_rates[i]);
-      translate.push_back(i);
-    }
-  }
-  if (tmp_vec.size() == 0) {
-    abort();
-  }
-  int in_cellDeathIndex = boost::random::discrete_distribution<>(tmp_vec)(rng);
-  in_cellDeathIndex = translate[in_cellDeathIndex];
-  if(death_cell.species[in_cellDeathIndex] != s) {
+  int in_cellDeathIndex = death_cell.FindByDeathRate(
+    s,
+    boost::random::uniform_01<>()(rng) * death_cell.SpeciesDeathRate(s)
+  );
+  if(death_cell.Species(in_cellDeathIndex) != s) {
     std::cout << "Not that species" << std::endl;
     abort();
   }
   
-  SetLastEvent(death_cell.coords_x[in_cellDeathIndex], -1);
+  SetLastEvent(death_cell.Coord(in_cellDeathIndex), -1);
   
   auto cellKilled = GetUnit(cellDeathIndex, in_cellDeathIndex);
   
@@ -220,31 +278,18 @@ void Grid::kill_random(int s)
   //remove dead speciment
   SubDeathRate(cellKilled);
   DecrementPopulation(cellKilled);
-  death_cell.SwapWithLast(in_cellDeathIndex);
-  death_cell.Pop();
-}
-
-int Grid::GetRandomSpawnCell(int species) {
-  return boost::random::discrete_distribution<>(cell_population[species])(rng);
+  specimens.Remove(
+    cellDeathIndex,
+    in_cellDeathIndex,
+    s,
+    death_cell.Species(death_cell.Size() - 1)
+  );
+  death_cell.Remove(in_cellDeathIndex);
 }
 
-Unit Grid::GetRandomSpawnUnit(int cellIndex, int species) {
-  int eventIndex = boost::random::uniform_smallint<>(
-    0,
-    cell_population[species][cellIndex] - 1
-  )(rng);
-  ++eventIndex;
-  for (int i = 0; ; ++i) {
-    if (cell_at(cellIndex).species[i] == species) {
-      --eventIndex;
-    }
-    if (eventIndex == 0) {
-      eventIndex = i;
-      break;
-    }
-  }
-  
-  return GetUnit(cellIndex, eventIndex);
+Unit Grid::GetRandomSpawnUnit(int species) {
+  auto parent = specimens.Sample(rng, species);
+  return GetUnit(parent.Cell, parent.Slot);
 }
 
 double Grid::GetNewCoord(const Unit& unit) {
@@ -275,23 +320,38 @@ int Grid::GetNewCellIndex(DCoord x) {
 }
 
 Unit Grid::GetLastUnit(int cell) {
-  return GetUnit(cell, cell_at(cell).coords_x.size() - 1);
+  return GetUnit(cell, cell_at(cell).Size() - 1);
 }
 
 void Grid::IncrementPopulation(Unit& unit) {
+  occupied_cells.Set(unit.CellNum());
+  occupied_species_cells[unit.Species()].Set(unit.CellNum());
   ++unit.CellPopulation();
   ++total_population[unit.Species()];
+  ++all_population;
+  RefreshSpeciesRates(unit.Species());
 }
 
 void Grid::DecrementPopulation(Unit& unit) {
   --unit.CellPopulation();
   assert(unit.CellPopulation() >= 0);
+  if (unit.CellPopulation() == 0) {
+    occupied_species_cells[unit.Species()].Clear(unit.CellNum());
+    bool occupied = false;
+    for (auto s : RangeSpecies()) {
+      occupied = occupied || cell_population[s][unit.CellNum()] > 0;
+    }
+    if (!occupied) {
+      occupied_cells.Clear(unit.CellNum());
+    }
+  }
   --total_population[unit.Species()];
+  --all_population;
+  RefreshSpeciesRates(unit.Species());
 }
 
 void Grid::spawn_random(int s) {
-  int cellIndex = GetRandomSpawnCell(s);
-  auto parentCell = GetRandomSpawnUnit(cellIndex, s);
+  auto parentCell = GetRandomSpawnUnit(s);
   double coordNew = GetNewCoord(parentCell);
   
   if (!IsInArea(coordNew)) {
@@ -301,6 +361,7 @@ void Grid::spawn_random(int s) {
     
     auto newCellIndex = GetNewCellIndex(coordNew);
     cell_at(newCellIndex).Add(d[s], coordNew, s);
+    specimens.Add(newCellIndex, s);
     auto newCell = GetLastUnit(newCellIndex);
     
     AddDeathRate(newCell);
@@ -322,11 +383,7 @@ void Grid::spawn_random(int s) {
 }
 
 double Grid::GetRandomTime() {
-  double rates = 0;
-  for (auto s : RangeSpecies()) {
-    rates += total_population[s] * b[s] + total_death_rate[s];
-  }
-  return boost::random::exponential_distribution<>(rates)(rng);
+  return boost::random::exponential_distribution<>(species_rates.Total())(rng);
 }
 
 void Grid::make_event() {
@@ -336,15 +393,9 @@ void Grid::make_event() {
   ++event_count;
   time += GetRandomTime();
   //Rolling event according to global birth \ death rate
-  std::vector<double> dis(species_count * 2, 0);
-  for (auto s : RangeSpecies()) {
-    if (total_population[s] > 0) {
-      dis[2 * s + 0] = total_death_rate[s];
-      dis[2 * s + 1] = total_population[s] * b[s];
-    }
-  }
-  
-  auto t = boost::random::discrete_distribution<>(dis)(rng);
+  auto t = species_rates.Find(
+    boost::random::uniform_01<>()(rng) * species_rates.Total()
+  );
   int event = t % 2;
   int species = t / 2;
   if (event == 0) {
@@ -392,10 +443,39 @@ Grid::Grid(Rcpp::List params) {
   seed = Rcpp::as<int>(params["seed"]);
   rng = boost::random::lagged_fibonacci2281(uint32_t(seed));
   
-  cull_x = 3;
+  sampler = "sum_tree";
+  if (params.containsElementNamed("sampler")) {
+    sampler = Rcpp::as<std::string>(params["sampler"]);
+  }
+  if (!RateSampler::IsKnownKind(sampler)) {
+    Rcpp::stop("Unknown sampler: " + sampler);
+  }
+  
+  death_kernel = "spline";
+  if (params.containsElementNamed("death_kernel")) {
+    death_kernel = Rcpp::as<std::string>(params["death_kernel"]);
+  }
+  if (death_kernel != "spline" && death_kernel != "table") {
+    Rcpp::stop("Unknown death kernel: " + death_kernel);
+  }
+  death_tabulated = death_kernel == "table";
+  
+  death_kernel_tolerance = 1e-6;
+  if (params.containsElementNamed("death_kernel_tolerance")) {
+    death_kernel_tolerance = Rcpp::as<double>(params["death_kernel_tolerance"]);
+  }
+  if (death_tabulated && !(death_kernel_tolerance > 0)) {
+    Rcpp::stop("death_kernel_tolerance must be positive");
+  }
+  
+  cull_x = 0;
   event_count = 0;
   
-  cells = VEC<Cell>(cell_count_x);
+  arena = SpecimenArena<1>(cell_count_x);
+  cells.reserve(cell_count_x);
+  for (auto i : Range(cell_count_x)) {
+    cells.emplace_back(&arena, i);
+  }
   
   b = VEC<double>(species_count);
   d = VEC<double>(species_count);
@@ -403,6 +483,8 @@ Grid::Grid(Rcpp::List params) {
   dd = MakeMat<double>(species_count);
   death_cutoff_r = MakeMat<double>(species_count);
   death_kernel_spline = MakeMat<cubic_b_spline<double>>(species_count);
+  death_kernel_table = MakeMat<KernelTable>(species_count);
+  death_kernel_max_error = MakeMat<double>(species_count);
   birth_reverse_cdf_spline = VEC<cubic_b_spline<double>>(species_count);
   
   total_death_rate = VEC<double>(species_count);
@@ -431,6 +513,14 @@ Grid::Grid(Rcpp::List params) {
         0,
         0
       );
+      if (death_tabulated) {
+        const auto &spline = death_kernel_spline[i][j];
+        if (!death_kernel_table[i][j].Build([&spline](double r) { return spline(r); },
+                                            death_cutoff_r[i][j], dd[i][j], death_kernel_tolerance)) {
+          Rcpp::stop("Death kernel table " + n2 + " can not reach tolerance " + to_string(death_kernel_tolerance));
+        }
+        death_kernel_max_error[i][j] = death_kernel_table[i][j].MaxError();
+      }
       cull_x = std::max<int>(cull_x, ceil(death_cutoff_r[i][j] / (area_length_x / cell_count_x)));
     }
     
@@ -509,5 +599,6 @@ Grid::Grid(Rcpp::List params) {
                             2 * right_derivative);
   }
   
+  BuildLocalRanges();
   Initialize_death_rates();
 }
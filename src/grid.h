@@ -10,13 +10,26 @@
 #include "cell.h"
 #include "iterators.h"
 #include "unit.h"
+#include "rate_sampler.h"
+#include "specimen_index.h"
+#include "specimen_arena.h"
+#include "kernel_table.h"
+#include "occupancy_bitmap.h"
 
 using boost::math::cubic_b_spline;
 
 struct Grid {
+  // Cells refer into the arena, so the grid is not copyable
+  SpecimenArena<1> arena;
   VEC<Cell> cells;
   MAT<double> cell_death_rates;
   MAT<int> cell_population;
+  // Cells holding any specimen, and holding specimens of each species
+  OccupancyBitmap occupied_cells;
+  VEC<OccupancyBitmap> occupied_species_cells;
+  VEC<RateSampler> cell_death_rate_samplers;
+  std::string sampler;
+  SpecimenIndex specimens;
   
   double area_length_x;
   
@@ -34,6 +47,11 @@ struct Grid {
   VEC<int> total_population;
   VEC<double> total_death_rate;
   
+  // Leaves 2s and 2s+1 hold death and birth rates of species s,
+  // so the event type is drawn without touching every species
+  SumTree species_rates;
+  int all_population;
+  
   double time;
   size_t event_count;
   
@@ -41,10 +59,21 @@ struct Grid {
   
   MAT<cubic_b_spline<double>> death_kernel_spline;
   
+  // With death_kernel "table" pairs look dd * kernel up by squared distance
+  std::string death_kernel;
+  bool death_tabulated;
+  double death_kernel_tolerance;
+  MAT<KernelTable> death_kernel_table;
+  MAT<double> death_kernel_max_error;
+  
   VEC<cubic_b_spline<double>> birth_reverse_cdf_spline;
   
   int cull_x;
   
+  // Cells within cull_x of cell i are [local_begin[i], local_end[i])
+  VEC<int> local_begin;
+  VEC<int> local_end;
+  
   std::tuple<double, int> last_event;
   
 public:
@@ -64,6 +93,8 @@ public:
   
   UnitIterating RangeLocalUnits(int i);
   
+  void BuildLocalRanges();
+  
   double CalcInteraction(const Unit& cell1, const Unit& cell2);
   
   VEC<DCoord> get_all_coords();
@@ -72,6 +103,8 @@ public:
   
   VEC<double> get_all_death_rates();
   
+  void RefreshCellDeathRate(Unit& unit);
+  void RefreshSpeciesRates(int s);
   void AddDeathRate(Unit& unit);
   void SubDeathRate(Unit& unit);
   
@@ -85,9 +118,7 @@ public:
   
   void kill_random(int s);
   
-  int GetRandomSpawnCell(int species);
-  
-  Unit GetRandomSpawnUnit(int cellIndex, int species);
+  Unit GetRandomSpawnUnit(int species);
   
   double GetNewCoord(const Unit& unit);
   
@@ -112,6 +143,8 @@ public:
   void run_for(double time);
   
   Grid(Rcpp::List params);
+  Grid(const Grid&) = delete;
+  Grid& operator=(const Grid&) = delete;
 };
 
 #endif
@@ -0,0 +1,543 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <math.h>
+#include <boost/random.hpp>
+
+#include "poisson_grid.h"
+#include "sum_tree.h"
+
+#ifndef HYBRID_GRID_H
+#define HYBRID_GRID_H
+
+//Particle-continuum simulator of poisson_2d_hybrid, on the cells of a grid
+//simulator, particles, that keeps the specimens of sparse cells.
+//
+//Cells that reach continuum_threshold specimens are replaced by a mass, a
+//deterministic density that follows the mean-field equation of the process
+//
+//  dm(c)/dt = b * sum over c' of M(c - c') m(c') - m(c) * (d + dd * sum over c' of W(c' - c) rho(c'))
+//
+//where M(o) is the share of the offspring of a specimen uniform in a cell that
+//land o cells away, W(o) the death kernel integrated over the cell o cells away
+//and averaged over the first one, and rho the mass of a continuum cell, or the
+//specimens of a particle cell, over the cell volume. The sums take masses from
+//continuum cells only, rho from both.
+//
+//Time runs in steps of field_step. Over a step masses are held fixed and the
+//specimens run exact events, with two kinds on top of their own births and
+//deaths: each specimen dies of the masses around at dd * sum W rho of continuum
+//cells of its cell, and masses give birth into particle cells at b * sum M m.
+//Such an offspring has a parent drawn uniformly in a continuum cell and lands
+//as a specimen's would, drawn again until it lands in a particle cell, so it
+//stays as close to the mass as offspring of specimens do rather than being
+//spread over the cell. After 1000 misses it is put uniformly in a particle
+//cell drawn by M instead. An offspring of a specimen landing in a continuum
+//cell adds one to its mass. At the end of the step masses are advanced by exponential Euler
+//with the rates of its start, which keeps them positive and the steady state
+//exact. Then particle cells at continuum_threshold turn into as much mass, and
+//continuum cells below half of it into specimens placed uniformly, the mass
+//rounded up with the probability of its fraction.
+//
+//Births, deaths and conversions move mass between the two as the process does,
+//in expectation. The approximations are the mean field, which leaves out the
+//correlations between specimens of a continuum cell, specimens taken as spread
+//evenly over each cell where they meet masses, and masses held over a step.
+template < int Dim >
+struct Hybrid_nd {
+  Grid_nd < Dim > particles;
+
+  double continuum_threshold;
+  double field_step;
+
+  //Masses of continuum cells, zero in particle cells
+  std::vector < char > continuum;
+  std::vector < double > mass;
+  double cell_volume;
+
+  //Kernels W and M by cell offset, Dim entries per offset in offsets
+  std::vector < int > death_offsets;
+  std::vector < double > death_weights;
+  std::vector < int > birth_offsets;
+  std::vector < double > birth_weights;
+
+  //Rates of the current step. pressure is dd * sum W rho, of all cells around a
+  //continuum cell and of continuum cells around a particle cell, inflow the
+  //births from masses into a continuum cell. field_deaths samples particle cells
+  //by the deaths masses cause in them, field_births continuum cells by the
+  //births they make into particle cells.
+  std::vector < double > pressure;
+  std::vector < double > inflow;
+  SumTree field_deaths;
+  SumTree field_births;
+  std::vector < double > deaths;
+  std::vector < double > births;
+
+  //Steps run, and births and deaths the masses made in them
+  int field_steps;
+  double continuum_events;
+
+  int cell_count_total() const {
+    return particles.cell_count_total();
+  }
+
+  //Cell the offset away from the cell at index, -1 outside a killing boundary
+  int shifted(const int * index, const int * offset) const {
+    int neighbour[Dim];
+    for (int axis = 0; axis < Dim; axis++) {
+      int n = index[axis] + offset[axis];
+      if (!particles.periodic && (n < 0 || n >= particles.cell_count[axis])) return -1;
+      neighbour[axis] = (n % particles.cell_count[axis] + particles.cell_count[axis]) % particles.cell_count[axis];
+    }
+    return particles.cell_index(neighbour);
+  }
+
+  //Adds weight at displacement z to the cell offsets it falls between. A point
+  //uniform in a cell moved by z is in the cell o away with probability the
+  //product over axes of the hat function of z / cell width - o.
+  void spread(const double * z, double weight, std::map < std::vector < int >, double > & weights) const {
+    int low[Dim];
+    double fraction[Dim];
+    for (int axis = 0; axis < Dim; axis++) {
+      double t = z[axis] * particles.cell_count[axis] / particles.area_length[axis];
+      low[axis] = static_cast < int > (floor(t));
+      fraction[axis] = t - low[axis];
+    }
+    for (int corner = 0; corner < (1 << Dim); corner++) {
+      std::vector < int > offset(Dim);
+      double share = weight;
+      for (int axis = 0; axis < Dim; axis++) {
+        bool high = corner >> axis & 1;
+        offset[axis] = low[axis] + high;
+        share *= high ? fraction[axis] : 1 - fraction[axis];
+      }
+      if (share > 0)
+        weights[offset] += share;
+    }
+  }
+
+  static void flatten(const std::map < std::vector < int >, double > & weights, std::vector < int > & offsets, std::vector < double > & values) {
+    offsets.clear();
+    values.clear();
+    for (const auto & entry : weights) {
+      offsets.insert(offsets.end(), entry.first.begin(), entry.first.end());
+      values.push_back(entry.second);
+    }
+  }
+
+  //Directions evenly spread over the sphere, on which offspring displacements
+  //are averaged
+  static std::vector < double > directions() {
+    std::vector < double > result;
+    if (Dim == 1) {
+      result = { -1, 1 };
+    } else if (Dim == 2) {
+      const int count = 64;
+      for (int i = 0; i < count; i++) {
+        double angle = (i + 0.5) * 2 * M_PI / count;
+        result.push_back(cos(angle));
+        result.push_back(sin(angle));
+      }
+    } else {
+      //Fibonacci lattice
+      const int count = 256;
+      for (int i = 0; i < count; i++) {
+        double z = 1 - (2 * i + 1.0) / count;
+        double angle = i * M_PI * (3 - sqrt(5.0));
+        result.push_back(sqrt(1 - z * z) * cos(angle));
+        result.push_back(sqrt(1 - z * z) * sin(angle));
+        result.push_back(z);
+      }
+    }
+    return result;
+  }
+
+  //W by midpoint quadrature over displacements within death_cutoff_r, M over
+  //quantiles of the offspring distance and directions
+  void build_kernels() {
+    const int steps = 64;
+    const double radius = particles.death_cutoff_r;
+    const double step = 2 * radius / steps;
+    std::map < std::vector < int >, double > weights;
+    int point[Dim] = {};
+    while (true) {
+      double z[Dim];
+      double squared = 0;
+      for (int axis = 0; axis < Dim; axis++) {
+        z[axis] = (point[axis] + 0.5) * step - radius;
+        squared += z[axis] * z[axis];
+      }
+      if (squared < radius * radius)
+        spread(z, particles.death_spline(sqrt(squared)) * pow(step, Dim), weights);
+
+      int axis = Dim - 1;
+      while (axis >= 0 && point[axis] == steps - 1) {
+        point[axis] = 0;
+        axis--;
+      }
+      if (axis < 0) break;
+      point[axis]++;
+    }
+    flatten(weights, death_offsets, death_weights);
+
+    const int quantiles = 256;
+    std::vector < double > unit = directions();
+    int direction_count = unit.size() / Dim;
+    weights.clear();
+    for (int q = 0; q < quantiles; q++) {
+      double distance = particles.birth_inverse_rcdf_spline((q + 0.5) / quantiles);
+      for (int i = 0; i < direction_count; i++) {
+        double z[Dim];
+        for (int axis = 0; axis < Dim; axis++)
+          z[axis] = unit[i * Dim + axis] * distance;
+        spread(z, 1.0 / (quantiles * direction_count), weights);
+      }
+    }
+    flatten(weights, birth_offsets, birth_weights);
+  }
+
+  //Puts an offspring at the point, into the mass of a continuum cell
+  void place(const double * point) {
+    int cell = particles.cell_of(point);
+    if (continuum[cell]) {
+      mass[cell] += 1;
+      return;
+    }
+    particles.insert_offspring(point);
+    field_deaths.Set(cell, particles.cell_population[cell] * pressure[cell]);
+  }
+
+  void remove(int cell, int slot) {
+    particles.remove_specimen(cell, slot);
+    field_deaths.Set(cell, particles.cell_population[cell] * pressure[cell]);
+  }
+
+  void uniform_point(int cell, double * point) {
+    int index[Dim];
+    particles.grid_index(cell, index);
+    for (int axis = 0; axis < Dim; axis++) {
+      double width = particles.area_length[axis] / particles.cell_count[axis];
+      point[axis] = (index[axis] + boost::random::uniform_01 < > ()(particles.rng)) * width;
+    }
+  }
+
+  void convert_cells() {
+    for (int cell = 0; cell < cell_count_total(); cell++) {
+      if (!continuum[cell] && particles.cell_population[cell] >= continuum_threshold) {
+        mass[cell] = particles.cell_population[cell];
+        for (int slot = particles.cell_population[cell] - 1; slot >= 0; slot--)
+          particles.remove_specimen(cell, slot);
+        continuum[cell] = true;
+      } else if (continuum[cell] && mass[cell] < continuum_threshold / 2) {
+        int count = static_cast < int > (floor(mass[cell]));
+        count += boost::random::bernoulli_distribution < > (mass[cell] - count)(particles.rng);
+        continuum[cell] = false;
+        mass[cell] = 0;
+        for (int i = 0; i < count; i++) {
+          double point[Dim];
+          uniform_point(cell, point);
+          place(point);
+        }
+      }
+    }
+  }
+
+  void compute_rates() {
+    pressure.assign(cell_count_total(), 0);
+    inflow.assign(cell_count_total(), 0);
+    births.assign(cell_count_total(), 0);
+    deaths.resize(cell_count_total());
+    int death_count = death_weights.size();
+    int birth_count = birth_weights.size();
+    for (int cell = 0; cell < cell_count_total(); cell++) {
+      double amount = continuum[cell] ? mass[cell] : particles.cell_population[cell];
+      if (amount == 0) continue;
+      int index[Dim];
+      particles.grid_index(cell, index);
+
+      //W is symmetric, so what a cell feels from its neighbours is spread from each neighbour
+      double density = particles.dd * amount / cell_volume;
+      for (int k = 0; k < death_count; k++) {
+        int target = shifted(index, & death_offsets[k * Dim]);
+        if (target < 0) continue;
+        //Specimens feel one another exactly in particles
+        if (continuum[cell] || continuum[target])
+          pressure[target] += death_weights[k] * density;
+      }
+      if (!continuum[cell]) continue;
+      double leaving = 0;
+      for (int k = 0; k < birth_count; k++) {
+        int target = shifted(index, & birth_offsets[k * Dim]);
+        if (target < 0) continue;
+        if (continuum[target])
+          inflow[target] += particles.b * birth_weights[k] * amount;
+        else
+          leaving += birth_weights[k];
+      }
+      births[cell] = particles.b * amount * leaving;
+    }
+
+    for (int cell = 0; cell < cell_count_total(); cell++)
+      deaths[cell] = continuum[cell] ? 0 : particles.cell_population[cell] * pressure[cell];
+    field_deaths.Build(deaths);
+    field_births.Build(births);
+  }
+
+  //Offspring of the mass of the cell put uniformly in a particle cell, drawn by
+  //M among the particle cells around it
+  void field_birth_by_kernel(int cell) {
+    using boost::random::uniform_01;
+    int index[Dim];
+    particles.grid_index(cell, index);
+    int birth_count = birth_weights.size();
+    double leaving = 0;
+    for (int k = 0; k < birth_count; k++) {
+      int target = shifted(index, & birth_offsets[k * Dim]);
+      if (target >= 0 && !continuum[target])
+        leaving += birth_weights[k];
+    }
+    if (!(leaving > 0)) return;
+
+    double u = uniform_01 < > ()(particles.rng) * leaving;
+    int chosen = -1;
+    for (int k = 0; k < birth_count; k++) {
+      int target = shifted(index, & birth_offsets[k * Dim]);
+      if (target < 0 || continuum[target]) continue;
+      chosen = target;
+      u -= birth_weights[k];
+      if (u < 0) break;
+    }
+    double point[Dim];
+    uniform_point(chosen, point);
+    place(point);
+  }
+
+  //Birth from the mass of the cell into a particle cell. Tries are bounded, as
+  //the share of offspring leaving the cell is found by quadrature rather than
+  //from the draws themselves, and a cell whose offspring rarely leave it falls
+  //back on field_birth_by_kernel, so the birth is not lost.
+  template < bool Periodic >
+  void field_birth(int cell) {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+      double parent[Dim], point[Dim];
+      uniform_point(cell, parent);
+      if (!particles.template offspring_near < Periodic > (parent, point)) continue;
+      if (continuum[particles.cell_of(point)]) continue;
+      place(point);
+      return;
+    }
+    field_birth_by_kernel(cell);
+  }
+
+  //Exact events of the specimens with masses held fixed, until end
+  template < bool Periodic >
+  void run_particles(double end) {
+    using boost::random::uniform_01;
+    Grid_nd < Dim > & grid = particles;
+    while (true) {
+      if (grid.realtime_limit_passed())
+        return;
+      double births = grid.b * grid.total_population;
+      //Rounding leaves a trace of death rate behind the last specimen
+      double deaths = grid.total_population > 0 ? std::max(grid.total_death_rate, 0.0) : 0;
+      double rate = births + deaths + field_deaths.Total() + field_births.Total();
+      if (!(rate > 0)) {
+        grid.time = end;
+        return;
+      }
+      double next = grid.time + boost::random::exponential_distribution < > (rate)(grid.rng);
+      if (next >= end) {
+        grid.time = end;
+        return;
+      }
+      grid.time = next;
+      grid.event_count++;
+
+      double u = uniform_01 < > ()(grid.rng) * rate;
+      if (u < births) {
+        SpecimenHandle parent = grid.specimens.Sample(grid.rng, 0);
+        double point[Dim];
+        if (grid.template offspring_of < Periodic > (parent, point))
+          place(point);
+      } else if (u < births + deaths) {
+        int cell = grid.cell_death_rate_sampler.Sample(grid.rng);
+        SumTree & rates = grid.in_cell_death_rates[cell];
+        remove(cell, rates.Find(uniform_01 < > ()(grid.rng) * rates.Total()));
+      } else if (u < births + deaths + field_deaths.Total()) {
+        int cell = field_deaths.Find(uniform_01 < > ()(grid.rng) * field_deaths.Total());
+        remove(cell, boost::random::uniform_int_distribution < > (0, grid.cell_population[cell] - 1)(grid.rng));
+      } else {
+        int cell = field_births.Find(uniform_01 < > ()(grid.rng) * field_births.Total());
+        field_birth < Periodic > (cell);
+      }
+    }
+  }
+
+  void advance_masses(double step) {
+    for (int cell = 0; cell < cell_count_total(); cell++) {
+      if (!continuum[cell]) continue;
+      double decay = particles.d + pressure[cell];
+      double start = mass[cell];
+      double fading = exp(-decay * step);
+      mass[cell] = start * fading + (decay > 0 ? inflow[cell] * (1 - fading) / decay : inflow[cell] * step);
+      continuum_events += (inflow[cell] + decay * start) * step;
+    }
+  }
+
+  template < bool Periodic >
+  void run_step(double end) {
+    convert_cells();
+    compute_rates();
+    double start = particles.time;
+    run_particles < Periodic > (end);
+    advance_masses(particles.time - start);
+    field_steps++;
+  }
+
+  bool extinct() const {
+    return particles.total_population == 0 && get_continuum_mass() == 0;
+  }
+
+  template < bool Periodic >
+  void run_for_with(double time) {
+    double end = particles.time + time;
+    while (particles.time < end && !extinct() && !particles.realtime_limit_passed())
+      run_step < Periodic > (std::min(particles.time + field_step, end));
+  }
+
+  //Whole steps until as many events were made, by specimens and masses
+  template < bool Periodic >
+  void run_events_with(int events) {
+    double target = get_events() + events;
+    while (get_events() < target && !extinct() && !particles.realtime_limit_passed()) {
+      double before = get_events();
+      run_step < Periodic > (particles.time + field_step);
+      //Nothing can happen any more
+      if (get_events() == before) break;
+    }
+  }
+
+  void run_events(int events) {
+    if (events <= 0)
+      return;
+    if (particles.periodic) run_events_with < true > (events);
+    else                    run_events_with < false > (events);
+  }
+
+  void run_for(double time) {
+    if (time <= 0.0)
+      return;
+    if (particles.periodic) run_for_with < true > (time);
+    else                    run_for_with < false > (time);
+  }
+
+  void make_event() {
+    run_events(1);
+  }
+
+  double get_continuum_mass() const {
+    double total = 0;
+    for (int cell = 0; cell < cell_count_total(); cell++)
+      total += mass[cell];
+    return total;
+  }
+
+  int get_continuum_cells() const {
+    int count = 0;
+    for (int cell = 0; cell < cell_count_total(); cell++)
+      count += continuum[cell];
+    return count;
+  }
+
+  //Mass per volume of each cell, zero in particle cells, with x changing fastest
+  std::vector < double > get_continuum_density() const {
+    std::vector < double > density(cell_count_total());
+    int index[Dim];
+    for (int cell = 0; cell < cell_count_total(); cell++) {
+      particles.grid_index(cell, index);
+      int position = 0;
+      for (int axis = 0; axis < Dim; axis++)
+        position += index[axis] * particles.cell_stride[axis];
+      density[position] = mass[cell] / cell_volume;
+    }
+    return density;
+  }
+
+  double get_events() const {
+    return particles.event_count + continuum_events;
+  }
+
+  int get_total_population() const { return particles.total_population; }
+  double get_total_death_rate() const { return particles.total_death_rate; }
+  double get_time() const { return particles.time; }
+  bool get_periodic() const { return particles.periodic; }
+  double get_b() const { return particles.b; }
+  double get_d() const { return particles.d; }
+  double get_dd() const { return particles.dd; }
+  int get_seed() const { return particles.seed; }
+  double get_realtime_limit() const { return particles.realtime_limit; }
+  bool get_realtime_limit_reached() const { return particles.realtime_limit_reached; }
+
+  std::vector < double > get_all_death_rates() {
+    return particles.get_all_death_rates();
+  }
+
+  double get_death_spline_value(double at) {
+    return particles.get_death_spline_value(at);
+  }
+
+  double get_birth_inverse_rcdf_spline_value(double at) {
+    return particles.get_birth_inverse_rcdf_spline_value(at);
+  }
+
+  Hybrid_nd(Rcpp::List params): particles(params), field_steps(), continuum_events() {
+    if (particles.auto_cell_count)
+      Rcpp::stop("auto_cell_count is not supported by the hybrid engine, its cells are fixed");
+    if (particles.tau_leaping)
+      Rcpp::stop("tau_leaping is not supported by the hybrid engine");
+
+    continuum_threshold = 50;
+    if (params.containsElementNamed("continuum_threshold"))
+      continuum_threshold = Rcpp::as < double > (params["continuum_threshold"]);
+    if (!(continuum_threshold > 0))
+      Rcpp::stop("continuum_threshold must be positive");
+    field_step = 0.05;
+    if (params.containsElementNamed("field_step"))
+      field_step = Rcpp::as < double > (params["field_step"]);
+    if (!(field_step > 0))
+      Rcpp::stop("field_step must be positive");
+
+    cell_volume = 1;
+    for (int axis = 0; axis < Dim; axis++)
+      cell_volume *= particles.area_length[axis] / particles.cell_count[axis];
+    build_kernels();
+
+    continuum.assign(cell_count_total(), false);
+    mass.assign(cell_count_total(), 0);
+    pressure.assign(cell_count_total(), 0);
+    inflow.assign(cell_count_total(), 0);
+    field_deaths.Resize(cell_count_total());
+    field_births.Resize(cell_count_total());
+    convert_cells();
+  }
+};
+
+//Per-axis fields and methods for the Rcpp modules, which name them by axis
+
+template < int Dim, int Axis >
+double hybrid_area_length_of(Hybrid_nd < Dim > * hybrid) {
+  return hybrid->particles.area_length[Axis];
+}
+
+template < int Dim, int Axis >
+int hybrid_cell_count_of(Hybrid_nd < Dim > * hybrid) {
+  return hybrid->particles.cell_count[Axis];
+}
+
+template < int Dim, int Axis >
+std::vector < double > hybrid_all_coords_of(Hybrid_nd < Dim > * hybrid) {
+  return hybrid->particles.get_all_coords(Axis);
+}
+
+#endif
@@ -0,0 +1,185 @@
+#include <cassert>
+
+#include "interaction_kernel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define INTERACTION_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// Keeps the sums of squares unfused, even where the target has FMA
+#if defined(__GNUC__) && !defined(__clang__)
+#define UNFUSED __attribute__((optimize("fp-contract=off")))
+#else
+#define UNFUSED
+#endif
+
+// Squared distance between a point and specimen k, unrolled over the axes at
+// compile time. Coordinates of the specimen are shifted across the boundary first.
+template <int Axes>
+struct SquaredDistance {
+  static double At(const double* point, const double* const* coords, const double* shift, int k) {
+    double delta = point[Axes - 1] - coords[Axes - 1][k] + shift[Axes - 1];
+    return SquaredDistance<Axes - 1>::At(point, coords, shift, k) + delta * delta;
+  }
+};
+
+template <>
+struct SquaredDistance<0> {
+  static double At(const double*, const double* const*, const double*, int) {
+    return 0;
+  }
+};
+
+template <int Dim>
+UNFUSED static int ScanScalar(const double* point, const double* const* coords, const double* shift,
+                              int size, double cutoffSquared, int skip, int* slots, double* squaredDistances) {
+  int found = 0;
+  // Every specimen is written out and kept only if it is close enough,
+  // so the loop has no branches
+  for (int k = 0; k < size; ++k) {
+    double squaredDistance = SquaredDistance<Dim>::At(point, coords, shift, k);
+    slots[found] = k;
+    squaredDistances[found] = squaredDistance;
+    found += (squaredDistance <= cutoffSquared) & (k != skip);
+  }
+  return found;
+}
+
+#ifdef INTERACTION_KERNEL_X86
+
+// Lanes of a 4 bit mask in order, padded with zeros
+alignas(16) static const int CompactLanes[16][4] = {
+  {0, 0, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 1, 0, 0},
+  {2, 0, 0, 0}, {0, 2, 0, 0}, {1, 2, 0, 0}, {0, 1, 2, 0},
+  {3, 0, 0, 0}, {0, 3, 0, 0}, {1, 3, 0, 0}, {0, 1, 3, 0},
+  {2, 3, 0, 0}, {0, 2, 3, 0}, {1, 2, 3, 0}, {0, 1, 2, 3}
+};
+
+template <int Dim>
+__attribute__((target("avx2,popcnt"))) UNFUSED
+static int ScanAvx2(const double* point, const double* const* coords, const double* shift,
+                    int size, double cutoffSquared, int skip, int* slots, double* squaredDistances) {
+  __m256d here[Dim], across[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    here[axis] = _mm256_set1_pd(point[axis]);
+    across[axis] = _mm256_set1_pd(shift[axis]);
+  }
+  const __m256d cutoff = _mm256_set1_pd(cutoffSquared);
+  const __m256i lane_numbers = _mm256_set_epi64x(3, 2, 1, 0);
+
+  int found = 0;
+  for (int k = 0; k < size; k += 4) {
+    // The last step loads only the specimens that are left
+    __m256i loaded = _mm256_cmpgt_epi64(_mm256_set1_epi64x(size - k), lane_numbers);
+    __m256d squared = _mm256_setzero_pd();
+    for (int axis = 0; axis < Dim; ++axis) {
+      __m256d delta = _mm256_add_pd(_mm256_sub_pd(here[axis], _mm256_maskload_pd(coords[axis] + k, loaded)), across[axis]);
+      squared = _mm256_add_pd(squared, _mm256_mul_pd(delta, delta));
+    }
+    unsigned mask = _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(squared, cutoff, _CMP_LE_OQ),
+                                                     _mm256_castsi256_pd(loaded)));
+    if (static_cast<unsigned>(skip - k) < 4) {
+      mask &= ~(1u << (skip - k));
+    }
+    // Kept lanes are moved to the front and all four are stored, the next
+    // store starts right after the kept ones
+    __m128i lanes = _mm_load_si128(reinterpret_cast<const __m128i*>(CompactLanes[mask]));
+    __m256i halves = _mm256_cvtepi32_epi64(lanes);
+    halves = _mm256_slli_epi64(halves, 1);
+    halves = _mm256_or_si256(halves, _mm256_slli_epi64(_mm256_add_epi64(halves, _mm256_set1_epi64x(1)), 32));
+    _mm256_storeu_pd(squaredDistances + found, _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(squared), halves)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(slots + found), _mm_add_epi32(lanes, _mm_set1_epi32(k)));
+    found += __builtin_popcount(mask);
+  }
+  return found;
+}
+
+template <int Dim>
+__attribute__((target("avx512f,popcnt"))) UNFUSED
+static int ScanAvx512(const double* point, const double* const* coords, const double* shift,
+                      int size, double cutoffSquared, int skip, int* slots, double* squaredDistances) {
+  __m512d here[Dim], across[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    here[axis] = _mm512_set1_pd(point[axis]);
+    across[axis] = _mm512_set1_pd(shift[axis]);
+  }
+  const __m512d cutoff = _mm512_set1_pd(cutoffSquared);
+  const __m512i lane_slots = _mm512_set_epi32(0, 0, 0, 0, 0, 0, 0, 0, 7, 6, 5, 4, 3, 2, 1, 0);
+
+  int found = 0;
+  for (int k = 0; k < size; k += 8) {
+    // The last step loads only the specimens that are left
+    __mmask8 lanes = size - k >= 8 ? 0xFF : (1u << (size - k)) - 1;
+    __m512d squared = _mm512_setzero_pd();
+    for (int axis = 0; axis < Dim; ++axis) {
+      __m512d delta = _mm512_add_pd(_mm512_sub_pd(here[axis], _mm512_maskz_loadu_pd(lanes, coords[axis] + k)), across[axis]);
+      squared = _mm512_add_pd(squared, _mm512_mul_pd(delta, delta));
+    }
+    unsigned mask = _mm512_mask_cmp_pd_mask(lanes, squared, cutoff, _CMP_LE_OQ);
+    if (static_cast<unsigned>(skip - k) < 8) {
+      mask &= ~(1u << (skip - k));
+    }
+    _mm512_mask_compressstoreu_pd(squaredDistances + found, mask, squared);
+    _mm512_mask_compressstoreu_epi32(slots + found, mask, _mm512_add_epi32(lane_slots, _mm512_set1_epi32(k)));
+    found += __builtin_popcount(mask);
+  }
+  return found;
+}
+
+#endif
+
+#undef UNFUSED
+
+static bool CpuSupports(const std::string& kind) {
+#ifdef INTERACTION_KERNEL_X86
+  if (kind == "avx2") {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+  }
+  if (kind == "avx512") {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+  }
+#endif
+  return kind == "scalar";
+}
+
+InteractionKernel::InteractionKernel()
+  : InteractionKernel("scalar")
+{ }
+
+InteractionKernel::InteractionKernel(const std::string& kind)
+  : _Kind(kind)
+{
+  assert(IsKnownKind(kind) && IsSupported(kind));
+  if (_Kind == "auto") {
+    _Kind = CpuSupports("avx512") ? "avx512" : CpuSupports("avx2") ? "avx2" : "scalar";
+  }
+
+  Scans[0] = ScanScalar<1>;
+  Scans[1] = ScanScalar<2>;
+  Scans[2] = ScanScalar<3>;
+#ifdef INTERACTION_KERNEL_X86
+  if (_Kind == "avx2") {
+    Scans[0] = ScanAvx2<1>;
+    Scans[1] = ScanAvx2<2>;
+    Scans[2] = ScanAvx2<3>;
+  }
+  if (_Kind == "avx512") {
+    Scans[0] = ScanAvx512<1>;
+    Scans[1] = ScanAvx512<2>;
+    Scans[2] = ScanAvx512<3>;
+  }
+#endif
+}
+
+bool InteractionKernel::IsKnownKind(const std::string& kind) {
+  return kind == "auto" || kind == "scalar" || kind == "avx2" || kind == "avx512";
+}
+
+bool InteractionKernel::IsSupported(const std::string& kind) {
+  return kind == "auto" || CpuSupports(kind);
+}
+
+const std::string& InteractionKernel::Kind() const {
+  return _Kind;
+}
@@ -0,0 +1,48 @@
+#ifndef INTERACTION_KERNEL
+#define INTERACTION_KERNEL
+
+#include <string>
+
+#include "defines.h"
+
+// Neighbour scan of one cell: squared distances from a point to specimens
+// [0, size) of the cell, keeping the slots within the cutoff. The version is
+// picked per simulator with the "interaction_kernel" parameter:
+//   "auto"    widest version the CPU supports (default)
+//   "scalar"  portable loop
+//   "avx2"    4 specimens per step
+//   "avx512"  8 specimens per step
+// All versions sum the axes in the same order and never fuse multiply-add,
+// so they find the same neighbours at bitwise equal distances.
+class InteractionKernel {
+public:
+  // Writes slots and squared distances of the specimens found, except slot
+  // skip, and returns their count. Both outputs need room for size + Padding
+  // entries, as vector versions store whole vectors.
+  typedef int (*ScanFunction)(const double* point, const double* const* coords, const double* shift,
+               int size, double cutoffSquared, int skip, int* slots, double* squaredDistances);
+
+private:
+  std::string _Kind;
+  ScanFunction Scans[3];
+
+public:
+  static const int Padding = 8;
+
+  InteractionKernel();
+  explicit InteractionKernel(const std::string& kind);
+
+  static bool IsKnownKind(const std::string& kind);
+  static bool IsSupported(const std::string& kind);
+
+  // Version in use, "auto" is resolved on construction
+  const std::string& Kind() const;
+
+  template <int Dim>
+  int Scan(const double* point, const double* const* coords, const double* shift,
+           int size, double cutoffSquared, int skip, int* slots, double* squaredDistances) const {
+    return Scans[Dim - 1](point, coords, shift, size, cutoffSquared, skip, slots, squaredDistances);
+  }
+};
+
+#endif
@@ -38,22 +38,24 @@ UnitIterator::UnitIterator(
   VEC<Cell>& cells,
   MAT<double>& cellsDeathRate,
   MAT<int>& cellsPopulation,
+  const OccupancyBitmap& occupied,
   int i,
+  int end,
   bool isEnd
 )
   : Cells(cells)
   , CellsDeathRate(cellsDeathRate)
   , CellsPopulation(cellsPopulation)
+  , Occupied(occupied)
   , I(i)
   , J(0)
+  , End(end)
   , IsEnd(isEnd)
 {
   if (isEnd) {
     return;
   }
-  while (Cells[I].coords_x.empty() && I != Cells.size()) {
-    ++I;
-  }
+  I = Occupied.Next(I, End);
 }
 
 Unit UnitIterator::operator*() {
@@ -62,11 +64,8 @@ Unit UnitIterator::operator*() {
 
 void UnitIterator::operator++() {
   ++J;
-  if (J == Cells[I].coords_x.size()) {
-    ++I;
-    while (Cells[I].coords_x.empty() && I != Cells.size()) {
-      ++I;
-    }
+  if (J == Cells[I].Size()) {
+    I = Occupied.Next(I + 1, End);
     J = 0;
   }
 }
@@ -95,12 +94,14 @@ UnitIterating::UnitIterating(
   VEC<Cell>& cells,
   MAT<double>& cellsDeathRate,
   MAT<int>& cellsPopulation,
+  const OccupancyBitmap& occupied,
   int minCell,
   int maxCell
 )
   : Cells(cells)
 , CellsDeathRate(cellsDeathRate)
 , CellsPopulation(cellsPopulation)
+, Occupied(occupied)
 , MinCell(minCell)
 , MaxCell(maxCell)
 {}
@@ -110,7 +111,9 @@ UnitIterator UnitIterating::begin() {
     Cells,
     CellsDeathRate,
     CellsPopulation,
+    Occupied,
     MinCell,
+    MaxCell,
     false
   );
 }
@@ -120,6 +123,8 @@ UnitIterator UnitIterating::end() {
     Cells,
     CellsDeathRate,
     CellsPopulation,
+    Occupied,
+    MaxCell,
     MaxCell,
     true
   );
@@ -4,6 +4,7 @@
 #include "defines.h"
 #include "cell.h"
 #include "unit.h"
+#include "occupancy_bitmap.h"
 
 class Iterator {
   int I;
@@ -28,11 +29,15 @@ struct Range {
   Iterator end() const;
 };
 
+// Visits units of cells [i, end) in order, empty cells are skipped by
+// scanning the occupancy bitmap
 class UnitIterator {
   VEC<Cell>& Cells;
   MAT<double>& CellsDeathRate;
   MAT<int>& CellsPopulation;
+  const OccupancyBitmap& Occupied;
   int I, J;
+  int End;
   bool IsEnd;
   
 public:
@@ -40,7 +45,9 @@ public:
     VEC<Cell>& cells,
     MAT<double>& cellsDeathRate,
     MAT<int>& cellsPopulation,
+    const OccupancyBitmap& occupied,
     int i,
+    int end,
     bool isEnd
   );
   
@@ -54,6 +61,7 @@ class UnitIterating {
   VEC<Cell>& Cells;
   MAT<double>& CellsDeathRate;
   MAT<int>& CellsPopulation;
+  const OccupancyBitmap& Occupied;
   const int MinCell, MaxCell;
   
 public:
@@ -61,6 +69,7 @@ public:
     VEC<Cell>& cells,
     MAT<double>& cellsDeathRate,
     MAT<int>& cellsPopulation,
+    const OccupancyBitmap& occupied,
     int minCell,
     int maxCell
   );
@@ -0,0 +1,60 @@
+#include <cmath>
+#include <algorithm>
+
+#include "kernel_table.h"
+
+KernelTable::KernelTable()
+  : _CutoffSquared(0)
+  , InverseStep(0)
+  , Error(0)
+  , Values(2, 0)
+{ }
+
+double KernelTable::MeasureError(const std::function<double(double)>& kernel, double cutoff) const {
+  // Interpolation error peaks inside the intervals, so each one is probed
+  // at several points besides its nodes
+  const int probes = 8;
+  int intervals = Values.size() - 2;
+  double error = 0;
+  for (int i = 0; i < intervals; ++i) {
+    for (int j = 0; j < probes; ++j) {
+      double r2 = (i + double(j) / probes) / InverseStep;
+      r2 = std::min(r2, _CutoffSquared);
+      error = std::max(error, std::abs(Interpolate(r2) - kernel(std::sqrt(r2))));
+    }
+  }
+  return std::max(error, std::abs(Interpolate(_CutoffSquared) - kernel(cutoff)));
+}
+
+bool KernelTable::Build(const std::function<double(double)>& kernel, double cutoff, double scale, double tolerance) {
+  _CutoffSquared = cutoff * cutoff;
+  for (int intervals = MinIntervals; intervals <= MaxIntervals; intervals *= 2) {
+    InverseStep = intervals / _CutoffSquared;
+    Values.resize(intervals + 2);
+    for (int i = 0; i <= intervals; ++i) {
+      Values[i] = kernel(std::sqrt(std::min(i / InverseStep, _CutoffSquared)));
+    }
+    Values[intervals + 1] = Values[intervals];
+
+    Error = MeasureError(kernel, cutoff);
+    if (Error <= tolerance) {
+      for (auto &value : Values) {
+        value *= scale;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+double KernelTable::CutoffSquared() const {
+  return _CutoffSquared;
+}
+
+double KernelTable::MaxError() const {
+  return Error;
+}
+
+int KernelTable::Size() const {
+  return Values.size();
+}
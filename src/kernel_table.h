@@ -0,0 +1,51 @@
+#ifndef KERNEL_TABLE
+#define KERNEL_TABLE
+
+#include <functional>
+
+#include "defines.h"
+
+// Radial kernel tabulated over the squared distance, so a pair loop that has
+// r^2 at hand needs neither a sqrt nor a spline evaluation. Values are linearly
+// interpolated on a uniform grid over [0, cutoff^2]. The grid is refined until
+// the table is within the requested absolute error of the kernel at every
+// checked point, and the scale (dd) is multiplied in afterwards.
+class KernelTable {
+  double _CutoffSquared;
+  double InverseStep;
+  double Error;
+  VEC<double> Values;
+
+  double Interpolate(double r2) const;
+  double MeasureError(const std::function<double(double)>& kernel, double cutoff) const;
+
+public:
+  static const int MinIntervals = 256;
+  static const int MaxIntervals = 1 << 22;
+
+  KernelTable();
+
+  // Returns false when the tolerance is not met with MaxIntervals
+  bool Build(const std::function<double(double)>& kernel, double cutoff, double scale, double tolerance);
+
+  double CutoffSquared() const;
+  // Largest difference from the unscaled kernel seen while verifying the table
+  double MaxError() const;
+  int Size() const;
+
+  // Scaled kernel at squared distance r2, r2 is expected in [0, CutoffSquared()]
+  double operator()(double r2) const;
+};
+
+inline double KernelTable::Interpolate(double r2) const {
+  double x = r2 * InverseStep;
+  int i = static_cast<int>(x);
+  // The last value is repeated, so r2 == CutoffSquared() needs no branch
+  return Values[i] + (x - i) * (Values[i + 1] - Values[i]);
+}
+
+inline double KernelTable::operator()(double r2) const {
+  return Interpolate(r2);
+}
+
+#endif
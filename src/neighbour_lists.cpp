@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "neighbour_lists.h"
+
+NeighbourLists::NeighbourLists()
+  : Reserved(0)
+{ }
+
+int NeighbourLists::Add() {
+  if (FreeIds.empty()) {
+    Lists.emplace_back();
+    Generations.push_back(0);
+    return Lists.size() - 1;
+  }
+  int id = FreeIds.back();
+  FreeIds.pop_back();
+  return id;
+}
+
+// A full list first sheds its stale entries, and doubles unless that freed
+// half of it, so each pass is paid for by as many appends
+void NeighbourLists::Append(int id, const Link& link) {
+  VEC<Link>& list = Lists[id];
+  std::size_t capacity = list.capacity();
+  if (list.size() == capacity && capacity > 0) {
+    list.erase(std::remove_if(list.begin(), list.end(), [this](const Link& entry) { return !Live(entry); }), list.end());
+    if (2 * list.size() > capacity) {
+      list.reserve(2 * capacity);
+    }
+  }
+  list.push_back(link);
+  Reserved += list.capacity() - capacity;
+}
+
+void NeighbourLists::Connect(int a, int b, double interaction) {
+  assert(a != b);
+  Append(a, Link{b, Generations[b], interaction});
+  Append(b, Link{a, Generations[a], interaction});
+}
+
+void NeighbourLists::Connect(int id, const int* others, const double* interactions, int count) {
+  const int ahead = 8;
+  for (int i = 0; i < count; ++i) {
+    if (i + 2 * ahead < count) {
+      __builtin_prefetch(&Lists[others[i + 2 * ahead]]);
+    }
+    if (i + ahead < count) {
+      const VEC<Link>& next = Lists[others[i + ahead]];
+      __builtin_prefetch(next.data() + next.size(), 1);
+    }
+    Append(others[i], Link{id, Generations[id], interactions[i]});
+  }
+  VEC<Link>& list = Lists[id];
+  std::size_t capacity = list.capacity();
+  list.reserve(list.size() + count);
+  for (int i = 0; i < count; ++i) {
+    list.push_back(Link{others[i], Generations[others[i]], interactions[i]});
+  }
+  Reserved += list.capacity() - capacity;
+}
+
+void NeighbourLists::Remove(int id) {
+  Generations[id]++;
+  // Lists of dead specimens give their memory back
+  Reserved -= Lists[id].capacity();
+  VEC<Link>().swap(Lists[id]);
+  FreeIds.push_back(id);
+}
+
+const VEC<NeighbourLists::Link>& NeighbourLists::Of(int id) const {
+  return Lists[id];
+}
+
+int NeighbourLists::Count() const {
+  return Lists.size() - FreeIds.size();
+}
+
+double NeighbourLists::Bytes() const {
+  return static_cast<double>(Reserved) * sizeof(Link)
+    + static_cast<double>(Lists.capacity()) * (sizeof(VEC<Link>) + sizeof(int))
+    + static_cast<double>(FreeIds.capacity()) * sizeof(int);
+}
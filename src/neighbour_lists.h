@@ -0,0 +1,56 @@
+#ifndef NEIGHBOUR_LISTS
+#define NEIGHBOUR_LISTS
+
+#include <cstddef>
+
+#include "defines.h"
+
+// Interacting pairs of specimens numbered by id, each pair kept in the lists
+// of both. Removing a specimen only frees its own list: entries naming it in
+// other lists go stale, as its id gets a new generation, and are skipped by
+// Live() and dropped when their list would otherwise grow. So removal costs
+// nothing per neighbour and stale entries never take more than the room a
+// list had anyway. Ids of removed specimens are reused.
+class NeighbourLists {
+public:
+  struct Link {
+    int Id;
+    int Generation;
+    double Interaction;
+  };
+
+private:
+  MAT<Link> Lists;
+  VEC<int> Generations;
+  VEC<int> FreeIds;
+  // Entries the lists have room for, to account memory without a pass
+  std::size_t Reserved;
+
+  void Append(int id, const Link& link);
+
+public:
+  NeighbourLists();
+
+  // Returns the id of a new specimen with an empty list
+  int Add();
+  // Frees the list and the id of the specimen
+  void Remove(int id);
+
+  // Both specimens are expected live and not yet linked
+  void Connect(int a, int b, double interaction);
+  // Links the specimen to count others at once. The lists of the others are
+  // scattered in memory, so they are fetched a few links ahead.
+  void Connect(int id, const int* others, const double* interactions, int count);
+
+  // Entries of the specimen, stale ones included
+  const VEC<Link>& Of(int id) const;
+  bool Live(const Link& link) const {
+    return Generations[link.Id] == link.Generation;
+  }
+
+  int Count() const;
+  // Heap memory of the lists and their headers, in bytes
+  double Bytes() const;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#include <algorithm>
+
+#include "occupancy_bitmap.h"
+
+OccupancyBitmap::OccupancyBitmap()
+{ }
+
+OccupancyBitmap::OccupancyBitmap(int size)
+  : Words((size + 63) / 64, 0)
+{ }
+
+void OccupancyBitmap::Set(int i) {
+  Words[i >> 6] |= uint64_t(1) << (i & 63);
+}
+
+void OccupancyBitmap::Clear(int i) {
+  Words[i >> 6] &= ~(uint64_t(1) << (i & 63));
+}
+
+int OccupancyBitmap::Next(int from, int end) const {
+  if (from >= end) {
+    return end;
+  }
+  int word = from >> 6;
+  int lastWord = (end - 1) >> 6;
+  // Bits below from are masked off in the first word
+  uint64_t bits = Words[word] & (~uint64_t(0) << (from & 63));
+  while (bits == 0) {
+    if (++word > lastWord) {
+      return end;
+    }
+    bits = Words[word];
+  }
+  return std::min(end, word * 64 + __builtin_ctzll(bits));
+}
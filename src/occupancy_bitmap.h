@@ -0,0 +1,29 @@
+#ifndef OCCUPANCY_BITMAP
+#define OCCUPANCY_BITMAP
+
+#include <cstdint>
+
+#include "defines.h"
+
+// One bit per cell, set while the cell holds a specimen. Scans for the next
+// occupied cell test 64 cells per word and jump to the first set bit, so runs
+// of empty cells in sparse grids cost a word each instead of a cell each.
+class OccupancyBitmap {
+  VEC<uint64_t> Words;
+
+public:
+  OccupancyBitmap();
+  explicit OccupancyBitmap(int size);
+
+  void Set(int i);
+  void Clear(int i);
+
+  bool Test(int i) const {
+    return Words[i >> 6] >> (i & 63) & 1;
+  }
+
+  // First occupied cell in [from, end), end if there is none
+  int Next(int from, int end) const;
+};
+
+#endif
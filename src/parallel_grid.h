@@ -0,0 +1,1368 @@
+#include <Rcpp.h>
+#include <chrono>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <random>
+#include <thread>
+#include <math.h>
+#include <boost/random.hpp>
+#include <boost/random/lagged_fibonacci.hpp>
+#include <boost/random/taus88.hpp>
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/math/interpolators/cardinal_cubic_b_spline.hpp>
+
+#include "sum_tree.h"
+#include "rate_sampler.h"
+#include "specimen_index.h"
+#include "specimen_arena.h"
+#include "kernel_table.h"
+#include "interaction_kernel.h"
+#include "worker_pool.h"
+#include "cell_blocks.h"
+#include "boundary.h"
+#include "dispersal.h"
+
+#ifndef PARALLEL_GRID_H
+#define PARALLEL_GRID_H
+
+//Multi-threaded simulator shared by poisson_1d_parallel, poisson_2d_parallel
+//and poisson_3d_parallel, on the cells of the grid simulators.
+//
+//Cells are split into blocks coloured by the parity of their position, by the
+//CellBlocks that Grid_nd::sweep_blocks also uses. Each block keeps its own
+//specimens, cell rates, death cell sampler, parent index and random stream.
+//Time runs in windows of time_window. In a window every colour in turn, in an
+//order drawn per window, runs all its blocks at once, each block drawing the
+//events of its own specimens from its own rates until its clock passes the end
+//of the window (synchronous sublattice scheme). An event reads and writes
+//death rates only within cull cells of its block, so blocks of one colour,
+//which are a whole block apart, never touch the same cell. Rates a block
+//changes in cells of other blocks reach their samplers at the barrier after
+//its colour, together with its offspring that landed in other blocks.
+//
+//Death rates always equal the interactions of the current specimens, exactly
+//as in the grid simulators, and a block alone follows the exact process. The
+//approximation is in time order across block borders: within a window the
+//colours run one after another, so an interaction between blocks of different
+//colours may be seen out of order by up to time_window, and offspring landing
+//in another block are added at the end of their colour, up to time_window
+//late. border_events and deferred_births count the events concerned, and the
+//process tends to that of the grid simulators as time_window goes to 0.
+//Trajectories do not depend on the number of threads.
+//
+//With parallel_mode "optimistic" all blocks run at once instead, each on its
+//own clock, and events seen out of order are rolled back, so the process is
+//exact, see the comment on it above ghost_index.
+template < int Dim >
+struct Parallel_nd {
+  struct Block {
+    //Coordinates and death rates of the specimens, by cell of the block
+    SpecimenArena < Dim > cells;
+    std::vector < SumTree > in_cell_death_rates;
+    std::vector < double > cell_death_rates;
+    RateSampler cell_death_rate_sampler;
+    SpecimenIndex specimens;
+    boost::random::lagged_fibonacci2281 rng;
+    int population;
+
+    //Cells of other blocks whose rates the block changed, offspring it placed
+    //in other blocks, both handed over at the barrier, to stale_cells and
+    //immigrants of the blocks they belong to
+    std::vector < int > touched_cells;
+    std::vector < double > migrants[Dim];
+    std::vector < int > stale_cells;
+    std::vector < double > immigrants[Dim];
+
+    int events;
+    int border_events;
+
+    //Scratch space of collect_neighbours
+    std::vector < int > neighbour_end;
+    std::vector < int > neighbour_slots;
+    std::vector < double > neighbour_squared_distances;
+
+    Block(): population(), events(), border_events() { }
+  };
+
+  //Order of events and messages in the optimistic mode. An event of a block is
+  //(time, block, its sequence number in the block, 0, block), a message sent
+  //while handling an item has the key of the item with hop one higher and the
+  //sender in place of the last field, so a message comes after its cause.
+  struct Key {
+    double time;
+    int origin;
+    int sequence;
+    int hop;
+    int sender;
+
+    bool operator < (const Key & other) const {
+      if (time != other.time) return time < other.time;
+      if (origin != other.origin) return origin < other.origin;
+      if (sequence != other.sequence) return sequence < other.sequence;
+      if (hop != other.hop) return hop < other.hop;
+      return sender < other.sender;
+    }
+  };
+
+  enum Message_kind { GHOST_BIRTH, GHOST_DEATH, IMMIGRANT };
+
+  //A specimen appearing in or leaving a cell the receiver keeps a ghost copy
+  //of, or an offspring born into a cell of the receiver. An anti-message
+  //cancels the message with the same key.
+  struct Message {
+    Key key;
+    int kind;
+    int cell;
+    double coords[Dim];
+    bool anti;
+  };
+
+  //Change to the state of a block, kept until the window is committed so the
+  //item that made it can be undone
+  enum Undo_kind { UNDO_RATE, UNDO_CELL_RATE, UNDO_ADD, UNDO_REMOVE, UNDO_GHOST_ADD, UNDO_GHOST_REMOVE };
+
+  struct Undo {
+    int kind;
+    int cell;
+    int slot;
+    double value;
+    double coords[Dim];
+  };
+
+  //Event or message handled by a block, with the state it started from
+  struct Item {
+    Key key;
+    bool own;
+    Message message;
+    int undo_begin;
+    int sent_begin;
+    boost::random::taus88 rng;
+    double pending;
+    double clock;
+    int sequence;
+  };
+
+  struct Sent {
+    int receiver;
+    Message message;
+  };
+
+  //Time Warp state of a block. Ghosts are copies of the specimens of other
+  //blocks within cull cells, ghost_cells their cells in increasing order.
+  //The events of the block are drawn with rng, whose state is small enough to
+  //save with every item, the next one at pending.
+  struct Region {
+    SpecimenArena < Dim > ghosts;
+    std::vector < int > ghost_cells;
+    SumTree cell_rates;
+    SumTree cell_sizes;
+    boost::random::taus88 rng;
+    double clock;
+    double pending;
+    int sequence;
+
+    std::map < Key, Message > inputs;
+    std::vector < Item > history;
+    std::vector < Undo > undo_log;
+    std::vector < Sent > sent;
+
+    std::mutex mailbox_lock;
+    std::vector < Message > mailbox;
+    std::atomic < bool > has_mail;
+
+    int rollbacks;
+    int rolled_back_events;
+    int messages;
+
+    Region(): clock(), pending(), sequence(), has_mail(false), rollbacks(), rolled_back_events(), messages() { }
+  };
+
+  double area_length[Dim];
+
+  bool periodic;
+
+  //Cell (i, j, k) is i * cell_stride[0] + j * cell_stride[1] + k * cell_stride[2]
+  int cell_count[Dim];
+  int cell_stride[Dim];
+  int cull[Dim];
+
+  //Cells within the cull distance of each cell, see cell_blocks.h
+  CellStencils < Dim > stencils;
+
+  //Cells split into at most max_blocks blocks, see CellBlocks
+  int max_blocks;
+  int block_count;
+  CellBlocks < Dim > partition;
+  std::vector < Block > blocks;
+
+  double time_window;
+  int window_count;
+  int deferred_births;
+  int border_events;
+
+  //"window" runs colours in turn as above, "optimistic" runs all blocks at once
+  //with rollback, see run_optimistic_window
+  std::string parallel_mode;
+  bool optimistic;
+  std::vector < std::unique_ptr < Region > > regions;
+  //Blocks other than the owner keeping ghosts of cell i are
+  //cell_subscribers[cell_subscribers_begin[i]..cell_subscribers_begin[i + 1])
+  std::vector < int > cell_subscribers_begin;
+  std::vector < int > cell_subscribers;
+  double optimistic_step;
+  int rollbacks;
+  int rolled_back_events;
+  int messages;
+
+  std::string sampler;
+
+  //Distance scan of collect_neighbours, see interaction_kernel.h
+  std::string interaction_kernel;
+  InteractionKernel neighbour_scan;
+
+  int threads;
+  std::unique_ptr < WorkerPool > workers;
+
+  double b, d, dd;
+  int seed;
+  //Draws the order of colours in each window, events use the streams of the blocks
+  boost::random::lagged_fibonacci2281 rng;
+
+  std::vector < double > initial_population[Dim];
+
+  int total_population;
+
+  std::chrono::system_clock::time_point init_time;
+  double realtime_limit;
+  bool realtime_limit_reached;
+
+  //Sums of the blocks, brought up to date after every window
+  double total_death_rate;
+
+  double time;
+  int event_count;
+
+  std::vector<double> death_y;
+  double death_cutoff_r;
+  double death_step;
+  int death_spline_nodes;
+  boost::math::interpolators::cardinal_cubic_b_spline<double> death_spline;
+
+  std::string death_kernel;
+  bool death_tabulated;
+  double death_kernel_tolerance;
+  double death_kernel_max_error;
+  KernelTable death_table;
+
+  std::vector<double> birth_inverse_rcdf_y;
+  double birth_inverse_rcdf_step;
+  int birth_inverse_rcdf_nodes;
+  boost::math::interpolators::cardinal_cubic_b_spline<double> birth_inverse_rcdf_spline;
+
+  static std::string axis_name(int axis) {
+    return std::string(1, "xyz"[axis]);
+  }
+
+  int cell_count_total() const {
+    return cell_stride[Dim - 1] * cell_count[Dim - 1];
+  }
+
+  int cell_of(const double * coords) const {
+    int cell = 0;
+    for (int axis = 0; axis < Dim; axis++) {
+      int index = static_cast < int > (floor(coords[axis] * cell_count[axis] / area_length[axis]));
+      if (index == cell_count[axis]) index--;
+      cell += index * cell_stride[axis];
+    }
+    return cell;
+  }
+
+  double interaction_at(double squared_distance) const {
+    if (death_tabulated)
+      return death_table(squared_distance);
+    return dd * death_spline(sqrt(squared_distance));
+  }
+
+  void build_stencils() {
+    stencils.Build(cell_count, area_length, cull, death_cutoff_r, periodic, std::vector < int > (), std::vector < int > ());
+  }
+
+  void build_blocks() {
+    partition = CellBlocks < Dim > (cell_count, cull, max_blocks, std::vector < int > ());
+    block_count = partition.Count();
+    blocks.assign(block_count, Block());
+    for (int block = 0; block < block_count; block++) {
+      int size = partition.Cells(block).size();
+      blocks[block].cells = SpecimenArena < Dim > (size);
+      blocks[block].in_cell_death_rates.assign(size, SumTree());
+      blocks[block].cell_death_rates.assign(size, 0);
+      blocks[block].cell_death_rate_sampler = RateSampler(sampler);
+      blocks[block].specimens = SpecimenIndex(1, size);
+      std::seed_seq streams { uint32_t(seed), uint32_t(block) };
+      blocks[block].rng.seed(streams);
+    }
+  }
+
+  const double * coords_of(int axis, int cell) const {
+    return blocks[partition.BlockOf(cell)].cells.Coords(axis, partition.LocalOf(cell));
+  }
+
+  int cell_size(int cell) const {
+    return blocks[partition.BlockOf(cell)].cells.CellSize(partition.LocalOf(cell));
+  }
+
+  //Grid_nd::collect_neighbours for the cells of all blocks, with the scratch space of scratch
+  void collect_neighbours(Block & scratch, const double * point, int owner, int skip) const {
+    stencils.Collect(neighbour_scan, point, owner, skip, death_cutoff_r * death_cutoff_r,
+                     [&](int cell, double, int & first, int & last, const double ** coords) {
+      first = 0;
+      last = cell_size(cell);
+      for (int axis = 0; axis < Dim; axis++)
+        coords[axis] = coords_of(axis, cell);
+      return true;
+    }, scratch.neighbour_end, scratch.neighbour_slots, scratch.neighbour_squared_distances);
+  }
+
+  //Adds sign times the interaction with the point to the death rates of the
+  //specimens found by collect_neighbours and to the rate of cell owner, and
+  //returns the sum of the interactions. Samplers of other blocks than that of
+  //owner are left to settle_colour.
+  double apply_neighbours(Block & scratch, int owner, double sign) {
+    Block & home = blocks[partition.BlockOf(owner)];
+    int home_local = partition.LocalOf(owner);
+    double sum = 0;
+    bool border = false;
+    int n = 0;
+    for (int s = stencils.Begin(owner); s < stencils.End(owner); s++) {
+      int end = scratch.neighbour_end[s - stencils.Begin(owner)];
+      if (n == end) continue;
+
+      int cell = stencils.Cell(s);
+      Block & block = blocks[partition.BlockOf(cell)];
+      int local = partition.LocalOf(cell);
+      double * death_rates = block.cells.DeathRates(local);
+      SumTree & rates = block.in_cell_death_rates[local];
+      int first_slot = scratch.neighbour_slots[n];
+      double cell_sum = 0;
+      for (; n < end; n++) {
+        int k = scratch.neighbour_slots[n];
+        double interaction = interaction_at(scratch.neighbour_squared_distances[n]);
+        death_rates[k] += sign * interaction;
+        rates.SetLeaf(k, death_rates[k]);
+        cell_sum += interaction;
+      }
+      rates.SumLeaves(first_slot, scratch.neighbour_slots[end - 1]);
+      block.cell_death_rates[local] += sign * cell_sum;
+      home.cell_death_rates[home_local] += sign * cell_sum;
+      sum += cell_sum;
+      if (&block == &home) {
+        block.cell_death_rate_sampler.Set(local, block.cell_death_rates[local]);
+      } else {
+        scratch.touched_cells.push_back(cell);
+        border = true;
+      }
+    }
+    if (border)
+      scratch.border_events++;
+    return sum;
+  }
+
+  //Passes the cells the block changed in other blocks on to their owners
+  void hand_over_touched_cells(Block & scratch) {
+    for (int cell : scratch.touched_cells)
+      blocks[partition.BlockOf(cell)].stale_cells.push_back(partition.LocalOf(cell));
+    scratch.touched_cells.clear();
+  }
+
+  //Brings the samplers of the cells of the block other blocks changed up to date
+  void flush_stale_cells(Block & block) {
+    for (int local : block.stale_cells)
+      block.cell_death_rate_sampler.Set(local, block.cell_death_rates[local]);
+    block.stale_cells.clear();
+  }
+
+  //Puts a new specimen into the cell and adds its interactions to both sides
+  void insert_specimen(Block & scratch, int cell, const double * point) {
+    Block & block = blocks[partition.BlockOf(cell)];
+    int local = partition.LocalOf(cell);
+    int k = block.cells.Add(local, point, d);
+    block.specimens.Add(local, 0);
+    block.in_cell_death_rates[local].Push(d);
+    block.cell_death_rates[local] += d;
+    block.population++;
+
+    collect_neighbours(scratch, point, cell, k);
+    double new_death_rate = d + apply_neighbours(scratch, cell, 1);
+    block.cells.DeathRates(local)[k] = new_death_rate;
+    block.in_cell_death_rates[local].Set(k, new_death_rate);
+    block.cell_death_rate_sampler.Set(local, block.cell_death_rates[local]);
+  }
+
+  void kill_random(int index) {
+    Block & block = blocks[index];
+    int local = block.cell_death_rate_sampler.Sample(block.rng);
+    SumTree & rates = block.in_cell_death_rates[local];
+    int slot = rates.Find(boost::random::uniform_01 < > ()(block.rng) * rates.Total());
+    int cell = partition.Cells(index)[local];
+
+    double point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      point[axis] = block.cells.Coords(axis, local)[slot];
+    collect_neighbours(block, point, cell, slot);
+    apply_neighbours(block, cell, -1);
+
+    block.cell_death_rates[local] -= d;
+    if (block.cells.CellSize(local) == 1 || std::abs(block.cell_death_rates[local]) < 1e-10)
+      block.cell_death_rates[local] = 0;
+    block.cell_death_rate_sampler.Set(local, block.cell_death_rates[local]);
+
+    block.specimens.Remove(local, slot, 0, 0);
+    block.cells.Remove(local, slot);
+    rates.SwapWithLast(slot);
+    rates.Pop();
+    block.population--;
+  }
+
+  template < bool Periodic >
+  void spawn_random(int index) {
+    Block & block = blocks[index];
+    //Parent is chosen uniformly among the specimens of the block
+    SpecimenHandle parent = block.specimens.Sample(block.rng, 0);
+
+    double at[Dim], point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      at[axis] = block.cells.Coords(axis, parent.Cell)[parent.Slot];
+    draw_offspring < Dim > (birth_inverse_rcdf_spline, block.rng, at, point);
+
+    for (int axis = 0; axis < Dim; axis++) {
+      //Specimen failed to spawn and died outside area boundaries
+      if (!Boundary < Periodic > ::place(point[axis], area_length[axis])) return;
+    }
+
+    int cell = cell_of(point);
+    if (partition.BlockOf(cell) != index) {
+      for (int axis = 0; axis < Dim; axis++)
+        block.migrants[axis].push_back(point[axis]);
+      return;
+    }
+    insert_specimen(block, cell, point);
+  }
+
+  //Runs the events of the block from the start of the window until its end
+  template < bool Periodic >
+  void run_block(int index, double end) {
+    Block & block = blocks[index];
+    double clock = time;
+    while (block.population > 0) {
+      double birth_rate = block.population * b;
+      double rate = birth_rate + block.cell_death_rate_sampler.Total();
+      if (!(rate > 0))
+        return;
+      //Draws past the end are dropped, the next window draws afresh
+      clock += boost::random::exponential_distribution < > (rate)(block.rng);
+      if (clock > end)
+        return;
+      block.events++;
+      if (boost::random::bernoulli_distribution < > (birth_rate / rate)(block.rng) == 0) {
+        kill_random(index);
+      } else {
+        spawn_random < Periodic > (index);
+      }
+    }
+  }
+
+  //Barrier after the blocks of a colour ran. Their offspring in other blocks
+  //are handed to those blocks, which insert them colour by colour, all blocks
+  //of a colour at once: an insertion, like an event, only touches cells within
+  //cull of its block. Then every block brings the samplers of its cells that
+  //others changed up to date, also at once. Only the handing over is serial.
+  void settle_colour(const std::vector < int > & colour) {
+    for (int index : colour) {
+      Block & block = blocks[index];
+      for (int i = 0; i < static_cast < int > (block.migrants[0].size()); i++) {
+        double point[Dim];
+        for (int axis = 0; axis < Dim; axis++)
+          point[axis] = block.migrants[axis][i];
+        Block & receiver = blocks[partition.BlockOf(cell_of(point))];
+        for (int axis = 0; axis < Dim; axis++)
+          receiver.immigrants[axis].push_back(point[axis]);
+      }
+      deferred_births += block.migrants[0].size();
+      for (int axis = 0; axis < Dim; axis++)
+        block.migrants[axis].clear();
+    }
+
+    for (int receivers = 0; receivers < partition.ColourCount(); receivers++) {
+      const std::vector < int > & receiver_blocks = partition.Colour(receivers);
+      workers->Run(receiver_blocks.size(), [&](int i) {
+        Block & block = blocks[receiver_blocks[i]];
+        for (int k = 0; k < static_cast < int > (block.immigrants[0].size()); k++) {
+          double point[Dim];
+          for (int axis = 0; axis < Dim; axis++)
+            point[axis] = block.immigrants[axis][k];
+          insert_specimen(block, cell_of(point), point);
+        }
+        for (int axis = 0; axis < Dim; axis++)
+          block.immigrants[axis].clear();
+      });
+    }
+
+    for (Block & block : blocks)
+      hand_over_touched_cells(block);
+    workers->Run(block_count, [&](int index) { flush_stale_cells(blocks[index]); });
+  }
+
+  //Optimistic mode (Time Warp). Every block runs its events from its own rates
+  //on its own clock, without waiting for the others. What an event does to
+  //other blocks is sent to them as timestamped messages: births and deaths to
+  //the blocks keeping ghosts of the cell, offspring landing in another block
+  //to its owner. A block handles its events and messages in key order, so a
+  //message earlier than an item it already handled rolls it back: later items
+  //are undone from their undo logs, the random stream, clock and next event
+  //are restored, and messages those items sent are cancelled by anti-messages,
+  //which may roll back their receivers in turn. Once no message is left and
+  //every block has handled all items up to the end of the window, nothing
+  //before it can change and the window is committed.
+  //
+  //The rate of a block at any time is that of its specimens given all earlier
+  //events of every block, and its next event is drawn afresh after every
+  //change, so the committed trajectory is one of the same process as the grid
+  //simulators, with no approximation. It is the trajectory a serial run
+  //handling all items in key order would give, so it does not depend on the
+  //number of threads.
+
+  int ghost_index(const Region & region, int cell) const {
+    return std::lower_bound(region.ghost_cells.begin(), region.ghost_cells.end(), cell) - region.ghost_cells.begin();
+  }
+
+  void log_undo(Region & region, int kind, int cell, int slot, double value, const double * coords = nullptr) {
+    Undo undo;
+    undo.kind = kind;
+    undo.cell = cell;
+    undo.slot = slot;
+    undo.value = value;
+    for (int axis = 0; axis < Dim; axis++)
+      undo.coords[axis] = coords ? coords[axis] : 0;
+    region.undo_log.push_back(undo);
+  }
+
+  void set_specimen_rate(int index, int local, int slot, double rate) {
+    Block & block = blocks[index];
+    log_undo(*regions[index], UNDO_RATE, local, slot, block.cells.DeathRates(local)[slot]);
+    block.cells.DeathRates(local)[slot] = rate;
+    block.in_cell_death_rates[local].Set(slot, rate);
+  }
+
+  void set_cell_rate(int index, int local, double rate) {
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    log_undo(region, UNDO_CELL_RATE, local, 0, block.cell_death_rates[local]);
+    block.cell_death_rates[local] = rate;
+    region.cell_rates.Set(local, rate);
+  }
+
+  int add_owned(int index, int local, const double * coords, double rate) {
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    int slot = block.cells.Add(local, coords, rate);
+    block.in_cell_death_rates[local].Push(rate);
+    block.population++;
+    region.cell_sizes.Set(local, block.cells.CellSize(local));
+    log_undo(region, UNDO_ADD, local, slot, 0);
+    return slot;
+  }
+
+  void remove_owned(int index, int local, int slot) {
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    double coords[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      coords[axis] = block.cells.Coords(axis, local)[slot];
+    log_undo(region, UNDO_REMOVE, local, slot, block.cells.DeathRates(local)[slot], coords);
+    block.cells.Remove(local, slot);
+    block.in_cell_death_rates[local].SwapWithLast(slot);
+    block.in_cell_death_rates[local].Pop();
+    block.population--;
+    region.cell_sizes.Set(local, block.cells.CellSize(local));
+  }
+
+  void add_ghost(Region & region, int cell, const double * coords) {
+    int ghost = ghost_index(region, cell);
+    int slot = region.ghosts.Add(ghost, coords, 0);
+    log_undo(region, UNDO_GHOST_ADD, ghost, slot, 0);
+  }
+
+  //Ghosts are told apart by their coordinates only, those at the same point are interchangeable
+  void remove_ghost(Region & region, int cell, const double * coords) {
+    int ghost = ghost_index(region, cell);
+    int slot = 0;
+    while (!std::equal(coords, coords + Dim, coords_at(region.ghosts, ghost, slot).data()))
+      slot++;
+    log_undo(region, UNDO_GHOST_REMOVE, ghost, slot, 0, coords);
+    region.ghosts.Remove(ghost, slot);
+  }
+
+  static std::vector < double > coords_at(const SpecimenArena < Dim > & arena, int cell, int slot) {
+    std::vector < double > coords(Dim);
+    for (int axis = 0; axis < Dim; axis++)
+      coords[axis] = arena.Coords(axis, cell)[slot];
+    return coords;
+  }
+
+  //Undoes SpecimenArena::Remove of the slot, the specimen that took its place goes back to the end
+  static void reinsert(SpecimenArena < Dim > & arena, int cell, int slot, const double * coords, double rate) {
+    if (slot == arena.CellSize(cell)) {
+      arena.Add(cell, coords, rate);
+      return;
+    }
+    std::vector < double > moved = coords_at(arena, cell, slot);
+    arena.Add(cell, moved.data(), arena.DeathRates(cell)[slot]);
+    for (int axis = 0; axis < Dim; axis++)
+      arena.Coords(axis, cell)[slot] = coords[axis];
+    arena.DeathRates(cell)[slot] = rate;
+  }
+
+  void undo(int index, const Undo & undo) {
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    SumTree & rates = block.in_cell_death_rates[undo.cell];
+    switch (undo.kind) {
+    case UNDO_RATE:
+      block.cells.DeathRates(undo.cell)[undo.slot] = undo.value;
+      rates.Set(undo.slot, undo.value);
+      break;
+    case UNDO_CELL_RATE:
+      block.cell_death_rates[undo.cell] = undo.value;
+      region.cell_rates.Set(undo.cell, undo.value);
+      break;
+    case UNDO_ADD:
+      block.cells.Remove(undo.cell, undo.slot);
+      rates.Pop();
+      block.population--;
+      region.cell_sizes.Set(undo.cell, block.cells.CellSize(undo.cell));
+      break;
+    case UNDO_REMOVE:
+      if (undo.slot == rates.Count()) {
+        rates.Push(undo.value);
+      } else {
+        rates.Push(rates.Get(undo.slot));
+        rates.Set(undo.slot, undo.value);
+      }
+      reinsert(block.cells, undo.cell, undo.slot, undo.coords, undo.value);
+      block.population++;
+      region.cell_sizes.Set(undo.cell, block.cells.CellSize(undo.cell));
+      break;
+    case UNDO_GHOST_ADD:
+      region.ghosts.Remove(undo.cell, undo.slot);
+      break;
+    case UNDO_GHOST_REMOVE:
+      reinsert(region.ghosts, undo.cell, undo.slot, undo.coords, 0);
+      break;
+    }
+  }
+
+  //Calls found(owned, cell, slots, squared_distances, count) for each cell in
+  //the stencil of cell with specimens within death_cutoff_r of the point:
+  //cells of the block by their index in it, leaving out slot skip of the cell
+  //itself, and with ghosts also the ghost cells of the block
+  template < class Found >
+  void visit_neighbours(int index, const double * point, int cell, int skip, bool ghosts, Found found) {
+    const double cutoff_squared = death_cutoff_r * death_cutoff_r;
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    for (int s = stencils.Begin(cell); s < stencils.End(cell); s++) {
+      int other = stencils.Cell(s);
+      bool owned = partition.BlockOf(other) == index;
+      if (!owned && !ghosts) continue;
+      const SpecimenArena < Dim > & arena = owned ? block.cells : region.ghosts;
+      int local = owned ? partition.LocalOf(other) : ghost_index(region, other);
+      int size = arena.CellSize(local);
+      if (size == 0) continue;
+      if (static_cast < int > (block.neighbour_slots.size()) < size + InteractionKernel::Padding) {
+        block.neighbour_slots.resize(2 * (size + InteractionKernel::Padding));
+        block.neighbour_squared_distances.resize(2 * (size + InteractionKernel::Padding));
+      }
+      double shift[Dim];
+      const double * coords[Dim];
+      for (int axis = 0; axis < Dim; axis++) {
+        shift[axis] = stencils.Shift(axis, s);
+        coords[axis] = arena.Coords(axis, local);
+      }
+      int count = neighbour_scan.Scan < Dim > (point, coords, shift, size, cutoff_squared, s == stencils.Self(cell) ? skip : -1,
+                                               block.neighbour_slots.data(), block.neighbour_squared_distances.data());
+      if (count > 0)
+        found(owned, local, block.neighbour_slots.data(), block.neighbour_squared_distances.data(), count);
+    }
+  }
+
+  void post(int receiver, const Message & message) {
+    Region & region = *regions[receiver];
+    std::lock_guard < std::mutex > guard(region.mailbox_lock);
+    region.mailbox.push_back(message);
+    region.has_mail = true;
+  }
+
+  //Sends a message caused by the item the block is handling
+  void send(int index, int receiver, int kind, int cell, const double * coords) {
+    Region & region = *regions[index];
+    const Key & cause = region.history.back().key;
+    Message message;
+    message.key = Key { cause.time, cause.origin, cause.sequence, cause.hop + 1, index };
+    message.kind = kind;
+    message.cell = cell;
+    for (int axis = 0; axis < Dim; axis++)
+      message.coords[axis] = coords[axis];
+    message.anti = false;
+    region.sent.push_back(Sent { receiver, message });
+    region.messages++;
+    post(receiver, message);
+  }
+
+  void notify_subscribers(int index, int kind, int cell, const double * coords) {
+    for (int i = cell_subscribers_begin[cell]; i < cell_subscribers_begin[cell + 1]; i++)
+      send(index, cell_subscribers[i], kind, cell, coords);
+  }
+
+  //Adds sign times the interactions with the point to the specimens of the block found
+  void shift_owned_rates(int index, int local, const int * slots, const double * squared_distances, int count,
+                         double sign, double & sum) {
+    Block & block = blocks[index];
+    double cell_sum = 0;
+    for (int n = 0; n < count; n++) {
+      double interaction = interaction_at(squared_distances[n]);
+      set_specimen_rate(index, local, slots[n], block.cells.DeathRates(local)[slots[n]] + sign * interaction);
+      cell_sum += interaction;
+    }
+    set_cell_rate(index, local, block.cell_death_rates[local] + sign * cell_sum);
+    sum += cell_sum;
+  }
+
+  void optimistic_insert(int index, int cell, const double * point) {
+    Block & block = blocks[index];
+    int local = partition.LocalOf(cell);
+    int slot = add_owned(index, local, point, d);
+    double new_death_rate = d;
+    visit_neighbours(index, point, cell, slot, true, [&](bool owned, int other, const int * slots, const double * squared_distances, int count) {
+      if (owned) {
+        shift_owned_rates(index, other, slots, squared_distances, count, 1, new_death_rate);
+        return;
+      }
+      for (int n = 0; n < count; n++)
+        new_death_rate += interaction_at(squared_distances[n]);
+    });
+    set_specimen_rate(index, local, slot, new_death_rate);
+    set_cell_rate(index, local, block.cell_death_rates[local] + new_death_rate);
+    notify_subscribers(index, GHOST_BIRTH, cell, point);
+  }
+
+  void optimistic_kill(int index) {
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    int local = region.cell_rates.Find(boost::random::uniform_01 < > ()(region.rng) * region.cell_rates.Total());
+    SumTree & rates = block.in_cell_death_rates[local];
+    int slot = rates.Find(boost::random::uniform_01 < > ()(region.rng) * rates.Total());
+    int cell = partition.Cells(index)[local];
+
+    double point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      point[axis] = block.cells.Coords(axis, local)[slot];
+    double released = 0;
+    visit_neighbours(index, point, cell, slot, false, [&](bool, int other, const int * slots, const double * squared_distances, int count) {
+      shift_owned_rates(index, other, slots, squared_distances, count, -1, released);
+    });
+    double death_rate = block.cells.DeathRates(local)[slot];
+    remove_owned(index, local, slot);
+    set_cell_rate(index, local, block.cells.CellSize(local) == 0 ? 0 : block.cell_death_rates[local] - death_rate);
+    notify_subscribers(index, GHOST_DEATH, cell, point);
+  }
+
+  template < bool Periodic >
+  void optimistic_spawn(int index) {
+    Block & block = blocks[index];
+    Region & region = *regions[index];
+    //Parent is chosen uniformly among the specimens of the block
+    double rest;
+    int local = region.cell_sizes.Find(boost::random::uniform_01 < > ()(region.rng) * block.population, rest);
+    int slot = std::min < int > (rest, block.cells.CellSize(local) - 1);
+
+    double at[Dim], point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      at[axis] = block.cells.Coords(axis, local)[slot];
+    draw_offspring < Dim > (birth_inverse_rcdf_spline, region.rng, at, point);
+
+    for (int axis = 0; axis < Dim; axis++) {
+      //Specimen failed to spawn and died outside area boundaries
+      if (!Boundary < Periodic > ::place(point[axis], area_length[axis])) return;
+    }
+
+    int cell = cell_of(point);
+    if (partition.BlockOf(cell) != index)
+      send(index, partition.BlockOf(cell), IMMIGRANT, cell, point);
+    else
+      optimistic_insert(index, cell, point);
+  }
+
+  //Draws the next event of the block from its rates after a change
+  void draw_next_event(int index) {
+    Region & region = *regions[index];
+    double rate = blocks[index].population * b + region.cell_rates.Total();
+    region.pending = rate > 0 ? region.clock + boost::random::exponential_distribution < > (rate)(region.rng)
+                              : std::numeric_limits < double > ::infinity();
+  }
+
+  //Handles an event of the block, message null, or a message, saving the state
+  //it starts from
+  template < bool Periodic >
+  void handle(int index, const Key & key, const Message * message) {
+    Region & region = *regions[index];
+    Item item;
+    item.key = key;
+    item.own = message == nullptr;
+    if (message)
+      item.message = *message;
+    item.undo_begin = region.undo_log.size();
+    item.sent_begin = region.sent.size();
+    item.rng = region.rng;
+    item.pending = region.pending;
+    item.clock = region.clock;
+    item.sequence = region.sequence;
+    region.history.push_back(item);
+    region.clock = key.time;
+
+    if (!message) {
+      region.sequence++;
+      double birth_rate = blocks[index].population * b;
+      if (boost::random::bernoulli_distribution < > (birth_rate / (birth_rate + region.cell_rates.Total()))(region.rng) == 0)
+        optimistic_kill(index);
+      else
+        optimistic_spawn < Periodic > (index);
+    } else if (message->kind == GHOST_BIRTH) {
+      add_ghost(region, message->cell, message->coords);
+      double added = 0;
+      visit_neighbours(index, message->coords, message->cell, -1, false, [&](bool, int other, const int * slots, const double * squared_distances, int count) {
+        shift_owned_rates(index, other, slots, squared_distances, count, 1, added);
+      });
+    } else if (message->kind == GHOST_DEATH) {
+      remove_ghost(region, message->cell, message->coords);
+      double released = 0;
+      visit_neighbours(index, message->coords, message->cell, -1, false, [&](bool, int other, const int * slots, const double * squared_distances, int count) {
+        shift_owned_rates(index, other, slots, squared_distances, count, -1, released);
+      });
+    } else {
+      optimistic_insert(index, message->cell, message->coords);
+    }
+    draw_next_event(index);
+  }
+
+  void undo_last(int index) {
+    Region & region = *regions[index];
+    const Item & item = region.history.back();
+    for (int i = region.undo_log.size() - 1; i >= item.undo_begin; i--)
+      undo(index, region.undo_log[i]);
+    region.undo_log.resize(item.undo_begin);
+    for (int i = item.sent_begin; i < static_cast < int > (region.sent.size()); i++) {
+      Message anti = region.sent[i].message;
+      anti.anti = true;
+      post(region.sent[i].receiver, anti);
+    }
+    region.sent.resize(item.sent_begin);
+    region.rng = item.rng;
+    region.pending = item.pending;
+    region.clock = item.clock;
+    region.sequence = item.sequence;
+    if (item.own)
+      region.rolled_back_events++;
+    else
+      region.inputs.emplace(item.message.key, item.message);
+    region.history.pop_back();
+  }
+
+  //Undoes the items after key, and the one with the key itself if inclusive
+  void roll_back(int index, const Key & key, bool inclusive) {
+    Region & region = *regions[index];
+    region.rollbacks++;
+    while (!region.history.empty() && (key < region.history.back().key || (inclusive && !(region.history.back().key < key))))
+      undo_last(index);
+  }
+
+  void receive(int index) {
+    Region & region = *regions[index];
+    std::vector < Message > mail;
+    {
+      std::lock_guard < std::mutex > guard(region.mailbox_lock);
+      mail.swap(region.mailbox);
+      region.has_mail = false;
+    }
+    for (const Message & message : mail) {
+      if (!message.anti) {
+        //A straggler rolls the block back to before it
+        if (!region.history.empty() && message.key < region.history.back().key)
+          roll_back(index, message.key, false);
+        region.inputs.emplace(message.key, message);
+      } else {
+        //A message already handled is rolled back first, which returns it to the inputs
+        if (!region.inputs.count(message.key))
+          roll_back(index, message.key, true);
+        region.inputs.erase(message.key);
+      }
+    }
+  }
+
+  //Handles the items of the block in key order up to the end of the window
+  template < bool Periodic >
+  void advance(int index, double end) {
+    Region & region = *regions[index];
+    while (true) {
+      if (region.has_mail)
+        receive(index);
+      Key own { region.pending, index, region.sequence, 0, index };
+      if (!region.inputs.empty() && region.inputs.begin()->first < own) {
+        if (region.inputs.begin()->first.time > end)
+          return;
+        Message message = region.inputs.begin()->second;
+        region.inputs.erase(region.inputs.begin());
+        handle < Periodic > (index, message.key, &message);
+      } else {
+        if (!(region.pending <= end))
+          return;
+        handle < Periodic > (index, own, nullptr);
+      }
+    }
+  }
+
+  //Runs blocks until nothing before end can change and commits what they did,
+  //returning the number of events committed
+  template < bool Periodic >
+  int run_optimistic_step(double end) {
+    //Blocks that received messages after they stopped run again
+    bool settled = false;
+    while (!settled) {
+      workers->Run(block_count, [&](int index) { advance < Periodic > (index, end); });
+      settled = true;
+      for (const std::unique_ptr < Region > & region : regions)
+        settled = settled && !region->has_mail;
+    }
+    //Nothing up to end can be rolled back any more
+    int committed = 0;
+    for (int index = 0; index < block_count; index++) {
+      Region & region = *regions[index];
+      int events = 0;
+      for (const Item & item : region.history)
+        events += item.own;
+      blocks[index].events += events;
+      committed += events;
+      region.history.clear();
+      region.undo_log.clear();
+      region.sent.clear();
+    }
+    return committed;
+  }
+
+  //Rollbacks cascade the more, the further blocks run ahead of each other, so
+  //a window is committed in steps of optimistic_step, halved when more events
+  //are rolled back than half those committed and grown when few are. Where the
+  //steps end does not change the trajectory.
+  template < bool Periodic >
+  void run_optimistic_window(double end) {
+    while (time < end) {
+      double step_end = std::min(time + optimistic_step, end);
+      int rolled_back = 0;
+      for (const std::unique_ptr < Region > & region : regions)
+        rolled_back -= region->rolled_back_events;
+      int committed = run_optimistic_step < Periodic > (step_end);
+      for (const std::unique_ptr < Region > & region : regions)
+        rolled_back += region->rolled_back_events;
+      if (2 * rolled_back > committed)
+        optimistic_step = std::max(optimistic_step / 2, time_window * 1e-6);
+      else if (10 * rolled_back < committed)
+        optimistic_step = std::min(optimistic_step * 1.5, time_window);
+      time = step_end;
+    }
+    time = end;
+    window_count++;
+    sum_blocks();
+  }
+
+  //Ghost cells and their subscribers from the stencils, ghosts from the specimens
+  //of other blocks, and the first event of every block
+  void build_regions() {
+    std::vector < std::vector < int > > subscribers(cell_count_total());
+    std::vector < std::vector < int > > ghost_cells(block_count);
+    for (int cell = 0; cell < cell_count_total(); cell++) {
+      int owner = partition.BlockOf(cell);
+      for (int s = stencils.Begin(cell); s < stencils.End(cell); s++) {
+        int other = stencils.Cell(s);
+        if (partition.BlockOf(other) == owner) continue;
+        subscribers[other].push_back(owner);
+        ghost_cells[owner].push_back(other);
+      }
+    }
+    cell_subscribers_begin.assign(1, 0);
+    cell_subscribers.clear();
+    for (std::vector < int > & cells : subscribers) {
+      std::sort(cells.begin(), cells.end());
+      cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+      cell_subscribers.insert(cell_subscribers.end(), cells.begin(), cells.end());
+      cell_subscribers_begin.push_back(cell_subscribers.size());
+    }
+
+    regions.clear();
+    for (int index = 0; index < block_count; index++) {
+      regions.emplace_back(new Region());
+      Region & region = *regions.back();
+      Block & block = blocks[index];
+      std::vector < int > & cells = ghost_cells[index];
+      std::sort(cells.begin(), cells.end());
+      cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+      region.ghost_cells = cells;
+      region.ghosts = SpecimenArena < Dim > (cells.size());
+      for (int ghost = 0; ghost < static_cast < int > (cells.size()); ghost++) {
+        for (int k = 0; k < cell_size(cells[ghost]); k++) {
+          double coords[Dim];
+          for (int axis = 0; axis < Dim; axis++)
+            coords[axis] = coords_of(axis, cells[ghost])[k];
+          region.ghosts.Add(ghost, coords, 0);
+        }
+      }
+      region.ghosts.Repack();
+
+      std::vector < double > sizes;
+      for (int local = 0; local < static_cast < int > (partition.Cells(index).size()); local++)
+        sizes.push_back(block.cells.CellSize(local));
+      region.cell_rates.Build(block.cell_death_rates);
+      region.cell_sizes.Build(sizes);
+      std::seed_seq streams { uint32_t(seed), uint32_t(index) };
+      region.rng.seed(streams);
+      region.clock = time;
+      draw_next_event(index);
+    }
+  }
+
+  void sum_blocks() {
+    total_population = 0;
+    total_death_rate = 0;
+    event_count = 0;
+    border_events = 0;
+    rollbacks = 0;
+    rolled_back_events = 0;
+    messages = 0;
+    for (int index = 0; index < block_count; index++) {
+      const Block & block = blocks[index];
+      total_population += block.population;
+      event_count += block.events;
+      border_events += block.border_events;
+      if (!optimistic) {
+        total_death_rate += block.cell_death_rate_sampler.Total();
+        continue;
+      }
+      const Region & region = *regions[index];
+      total_death_rate += region.cell_rates.Total();
+      rollbacks += region.rollbacks;
+      rolled_back_events += region.rolled_back_events;
+      messages += region.messages;
+    }
+  }
+
+  //Runs a window ending at end, at most time_window ahead
+  template < bool Periodic >
+  void run_window(double end) {
+    if (optimistic) {
+      run_optimistic_window < Periodic > (end);
+      return;
+    }
+    std::vector < int > order(partition.ColourCount());
+    std::iota(order.begin(), order.end(), 0);
+    for (int i = order.size() - 1; i > 0; i--)
+      std::swap(order[i], order[boost::random::uniform_int_distribution < > (0, i)(rng)]);
+
+    for (int colour : order) {
+      const std::vector < int > & colour_block = partition.Colour(colour);
+      workers->Run(colour_block.size(), [&](int i) { run_block < Periodic > (colour_block[i], end); });
+      settle_colour(colour_block);
+    }
+    time = end;
+    window_count++;
+    sum_blocks();
+  }
+
+  //Death rates of every specimen from its neighbours, each computed by itself,
+  //so blocks run in parallel in any order
+  void Initialize_death_rates() {
+    for (int sp_index = 0; sp_index < static_cast < int > (initial_population[0].size()); sp_index++) {
+      double coords[Dim];
+      bool inside = true;
+      for (int axis = 0; axis < Dim; axis++) {
+        coords[axis] = initial_population[axis][sp_index];
+        if (coords[axis] < 0 || coords[axis] > area_length[axis]) inside = false;
+      }
+      if (!inside) continue;
+
+      int cell = cell_of(coords);
+      Block & block = blocks[partition.BlockOf(cell)];
+      block.cells.Add(partition.LocalOf(cell), coords, d);
+      block.specimens.Add(partition.LocalOf(cell), 0);
+      block.population++;
+    }
+
+    //Lay cells out in order before any block reads those of the others
+    workers->Run(block_count, [&](int index) { blocks[index].cells.Repack(); });
+    workers->Run(block_count, [&](int index) {
+      Block & block = blocks[index];
+      for (int local = 0; local < static_cast < int > (partition.Cells(index).size()); local++) {
+        int cell = partition.Cells(index)[local];
+        double * death_rates = block.cells.DeathRates(local);
+        for (int k = 0; k < block.cells.CellSize(local); k++) {
+          double point[Dim];
+          for (int axis = 0; axis < Dim; axis++)
+            point[axis] = block.cells.Coords(axis, local)[k];
+          collect_neighbours(block, point, cell, k);
+          int found = block.neighbour_end[stencils.End(cell) - stencils.Begin(cell) - 1];
+          for (int n = 0; n < found; n++)
+            death_rates[k] += interaction_at(block.neighbour_squared_distances[n]);
+        }
+        block.cell_death_rates[local] = std::accumulate(death_rates, death_rates + block.cells.CellSize(local), 0.0);
+        block.in_cell_death_rates[local].Build(std::vector < double > (death_rates, death_rates + block.cells.CellSize(local)));
+      }
+      block.cell_death_rate_sampler.Build(block.cell_death_rates);
+    });
+    if (optimistic)
+      build_regions();
+    sum_blocks();
+  }
+
+  std::vector < double > get_all_coords(int axis) {
+    std::vector < double > result;
+    result.reserve(total_population);
+    for (int cell = 0; cell < cell_count_total(); cell++)
+      result.insert(result.end(), coords_of(axis, cell), coords_of(axis, cell) + cell_size(cell));
+    return result;
+  }
+
+  std::vector < double > get_all_death_rates() {
+    std::vector < double > result;
+    result.reserve(total_population);
+    for (int cell = 0; cell < cell_count_total(); cell++) {
+      const Block & block = blocks[partition.BlockOf(cell)];
+      const double * death_rates = block.cells.DeathRates(partition.LocalOf(cell));
+      result.insert(result.end(), death_rates, death_rates + cell_size(cell));
+    }
+    return result;
+  }
+
+  bool realtime_limit_passed() {
+    if (std::chrono::system_clock::now() > init_time + std::chrono::duration<double>(realtime_limit)) {
+      realtime_limit_reached = true;
+      return true;
+    }
+    return false;
+  }
+
+  bool exhausted() const {
+    return total_population == 0 || !(total_population * b + total_death_rate > 0);
+  }
+
+  //Whole windows are run, so at least as many events as asked for are made
+  template < bool Periodic >
+  void run_events_with(int events) {
+    int target = event_count + events;
+    while (event_count < target && !exhausted()) {
+      if (realtime_limit_passed())
+        return;
+      run_window < Periodic > (time + time_window);
+    }
+  }
+
+  //The last window is cut short to end at the time asked for
+  template < bool Periodic >
+  void run_for_with(double time) {
+    double end = this->time + time;
+    while (this->time < end && !exhausted()) {
+      if (realtime_limit_passed())
+        return;
+      run_window < Periodic > (std::min(this->time + time_window, end));
+    }
+  }
+
+  //Runs one window
+  void make_event() {
+    if (exhausted())
+      return;
+    if (periodic) run_window < true > (time + time_window);
+    else          run_window < false > (time + time_window);
+  }
+
+  void run_events(int events) {
+    if (events <= 0)
+      return;
+    if (periodic) run_events_with < true > (events);
+    else          run_events_with < false > (events);
+  }
+
+  void run_for(double time) {
+    if (time <= 0.0)
+      return;
+    if (periodic) run_for_with < true > (time);
+    else          run_for_with < false > (time);
+  }
+
+  double get_death_spline_value(double at) {
+    return death_spline(at);
+  }
+
+  double get_birth_inverse_rcdf_spline_value(double at) {
+    return birth_inverse_rcdf_spline(at);
+  }
+
+  Parallel_nd(Rcpp::List params): window_count(), deferred_births(), border_events(),
+  rollbacks(), rolled_back_events(), messages(), total_population(), realtime_limit_reached(false), total_death_rate(),
+  time(), event_count(), death_spline(), birth_inverse_rcdf_spline() {
+
+    //Parse parameters
+
+    for (int axis = 0; axis < Dim; axis++) {
+      area_length[axis] = Rcpp::as < double > (params["area_length_" + axis_name(axis)]);
+      initial_population[axis] = Rcpp::as < std::vector < double >> (params["initial_population_" + axis_name(axis)]);
+    }
+
+    b = Rcpp::as < double > (params["b"]);
+    d = Rcpp::as < double > (params["d"]);
+    dd = Rcpp::as < double > (params["dd"]);
+
+    seed = Rcpp::as < int > (params["seed"]);
+    rng = boost::random::lagged_fibonacci2281(uint32_t(seed));
+
+    death_y = Rcpp::as < std::vector < double >> (params["death_y"]);
+    death_cutoff_r = Rcpp::as < double > (params["death_r"]);
+    death_spline_nodes = death_y.size();
+    death_step = death_cutoff_r / (death_spline_nodes - 1);
+
+    birth_inverse_rcdf_y = Rcpp::as < std::vector < double >> (params["birth_ircdf_y"]);
+    birth_inverse_rcdf_nodes = birth_inverse_rcdf_y.size();
+    birth_inverse_rcdf_step = 1.0 / (birth_inverse_rcdf_nodes - 1);
+
+    periodic = Rcpp::as < bool > (params["periodic"]);
+
+    sampler = "sum_tree";
+    if (params.containsElementNamed("sampler"))
+      sampler = Rcpp::as < std::string > (params["sampler"]);
+    if (!RateSampler::IsKnownKind(sampler))
+      Rcpp::stop("Unknown sampler: " + sampler);
+
+    interaction_kernel = "auto";
+    if (params.containsElementNamed("interaction_kernel"))
+      interaction_kernel = Rcpp::as < std::string > (params["interaction_kernel"]);
+    if (!InteractionKernel::IsKnownKind(interaction_kernel))
+      Rcpp::stop("Unknown interaction kernel: " + interaction_kernel);
+    if (!InteractionKernel::IsSupported(interaction_kernel))
+      Rcpp::stop("Interaction kernel " + interaction_kernel + " is not supported by this CPU");
+    neighbour_scan = InteractionKernel(interaction_kernel);
+    interaction_kernel = neighbour_scan.Kind();
+
+    threads = 1;
+    if (params.containsElementNamed("threads"))
+      threads = Rcpp::as < int > (params["threads"]);
+    if (threads < 1)
+      Rcpp::stop("threads must be positive");
+
+    time_window = 0.1;
+    if (params.containsElementNamed("time_window"))
+      time_window = Rcpp::as < double > (params["time_window"]);
+    if (!(time_window > 0))
+      Rcpp::stop("time_window must be positive");
+
+    max_blocks = 1024;
+    if (params.containsElementNamed("max_blocks"))
+      max_blocks = Rcpp::as < int > (params["max_blocks"]);
+    if (max_blocks < 1)
+      Rcpp::stop("max_blocks must be positive");
+
+    parallel_mode = "window";
+    if (params.containsElementNamed("parallel_mode"))
+      parallel_mode = Rcpp::as < std::string > (params["parallel_mode"]);
+    if (parallel_mode != "window" && parallel_mode != "optimistic")
+      Rcpp::stop("Unknown parallel mode: " + parallel_mode);
+    optimistic = parallel_mode == "optimistic";
+    optimistic_step = time_window;
+
+    init_time = std::chrono::system_clock::now();
+    realtime_limit = Rcpp::as<double>(params["realtime_limit"]);
+
+    using boost::math::interpolators::cardinal_cubic_b_spline;
+    //Build death spline, ensure 0 derivative at 0 (symmetric) and endpoint (expected no death interaction further)
+    death_spline = cardinal_cubic_b_spline < double > (death_y.begin(), death_y.end(), 0, death_step, 0, 0);
+
+    death_kernel = "spline";
+    if (params.containsElementNamed("death_kernel"))
+      death_kernel = Rcpp::as < std::string > (params["death_kernel"]);
+    if (death_kernel != "spline" && death_kernel != "table")
+      Rcpp::stop("Unknown death kernel: " + death_kernel);
+    death_tabulated = death_kernel == "table";
+
+    death_kernel_tolerance = 1e-6;
+    if (params.containsElementNamed("death_kernel_tolerance"))
+      death_kernel_tolerance = Rcpp::as < double > (params["death_kernel_tolerance"]);
+    death_kernel_max_error = 0;
+    if (death_tabulated) {
+      if (!(death_kernel_tolerance > 0))
+        Rcpp::stop("death_kernel_tolerance must be positive");
+      if (!death_table.Build([this](double r) { return death_spline(r); }, death_cutoff_r, dd, death_kernel_tolerance))
+        Rcpp::stop("Death kernel table can not reach tolerance " + std::to_string(death_kernel_tolerance));
+      death_kernel_max_error = death_table.MaxError();
+    }
+
+    for (int axis = 0; axis < Dim; axis++) {
+      cell_count[axis] = Rcpp::as < int > (params["cell_count_" + axis_name(axis)]);
+      if (cell_count[axis] < 1)
+        Rcpp::stop("cell_count must be positive");
+      cell_stride[axis] = axis == 0 ? 1 : cell_stride[axis - 1] * cell_count[axis - 1];
+      //Amount of cells to check around for death interaction
+      cull[axis] = static_cast < int > (ceil(death_cutoff_r / (area_length[axis] / cell_count[axis])));
+    }
+
+    //Build birth inverse rcdf spline, endpoint derivatives not specified
+    birth_inverse_rcdf_spline = cardinal_cubic_b_spline<double>(birth_inverse_rcdf_y.begin(), birth_inverse_rcdf_y.end(), 0, birth_inverse_rcdf_step);
+
+    build_stencils();
+    build_blocks();
+    workers.reset(new WorkerPool(threads));
+
+    //Spawn speciments and calculate death rates
+    Initialize_death_rates();
+  }
+};
+
+//Per-axis fields and methods for the Rcpp modules, which name them by axis
+
+template < int Dim, int Axis >
+double parallel_area_length_of(Parallel_nd < Dim > * sim) {
+  return sim->area_length[Axis];
+}
+
+template < int Dim, int Axis >
+int parallel_cell_count_of(Parallel_nd < Dim > * sim) {
+  return sim->cell_count[Axis];
+}
+
+template < int Dim, int Axis >
+int parallel_block_count_of(Parallel_nd < Dim > * sim) {
+  return sim->partition.Along(Axis);
+}
+
+template < int Dim, int Axis >
+std::vector < double > parallel_initial_population_of(Parallel_nd < Dim > * sim) {
+  return sim->initial_population[Axis];
+}
+
+template < int Dim, int Axis >
+std::vector < double > parallel_all_coords_of(Parallel_nd < Dim > * sim) {
+  return sim->get_all_coords(Axis);
+}
+
+#endif
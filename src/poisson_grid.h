@@ -0,0 +1,1266 @@
+#include <Rcpp.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <math.h>
+#include <boost/random.hpp>
+#include <boost/random/lagged_fibonacci.hpp>
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/math/interpolators/cardinal_cubic_b_spline.hpp>
+
+#include "sum_tree.h"
+#include "rate_sampler.h"
+#include "specimen_index.h"
+#include "specimen_arena.h"
+#include "kernel_table.h"
+#include "interaction_kernel.h"
+#include "cell_order.h"
+#include "occupancy_bitmap.h"
+#include "neighbour_lists.h"
+#include "cell_blocks.h"
+#include "worker_pool.h"
+#include "boundary.h"
+#include "dispersal.h"
+
+#ifndef POISSON_GRID_H
+#define POISSON_GRID_H
+
+//Parameters of Grid_nd, read from the list of initialize_simulator and
+//checked on the calling thread, so that the simulator can then be built from
+//plain C++ on any thread. Axes past the dimension of the grid are left unset,
+//and cell counts too with auto_cell_count.
+struct Grid_params {
+  double area_length[3];
+  int cell_count[3];
+  std::vector < double > initial_population[3];
+
+  double b, d, dd;
+  int seed;
+
+  std::vector < double > death_y;
+  double death_r;
+  std::vector < double > birth_ircdf_y;
+
+  bool periodic;
+  std::string sampler;
+  std::string interaction_kernel;
+  bool sorted_cells;
+  std::string cell_order;
+  int threads;
+  double realtime_limit;
+
+  std::string death_kernel;
+  double death_kernel_tolerance;
+
+  bool auto_cell_count;
+  double cell_occupancy;
+
+  bool neighbour_lists;
+  double neighbour_list_budget;
+
+  bool tau_leaping;
+  double tau_epsilon;
+  int tau_ssa_events;
+
+  static std::string axis_name(int axis) {
+    return std::string(1, "xyz"[axis]);
+  }
+
+  Grid_params(Rcpp::List params, int dim) {
+    for (int axis = 0; axis < dim; axis++) {
+      area_length[axis] = Rcpp::as < double > (params["area_length_" + axis_name(axis)]);
+      initial_population[axis] = Rcpp::as < std::vector < double >> (params["initial_population_" + axis_name(axis)]);
+    }
+
+    b = Rcpp::as < double > (params["b"]);
+    d = Rcpp::as < double > (params["d"]);
+    dd = Rcpp::as < double > (params["dd"]);
+
+    seed = Rcpp::as < int > (params["seed"]);
+
+    death_y = Rcpp::as < std::vector < double >> (params["death_y"]);
+    death_r = Rcpp::as < double > (params["death_r"]);
+    birth_ircdf_y = Rcpp::as < std::vector < double >> (params["birth_ircdf_y"]);
+
+    periodic = Rcpp::as < bool > (params["periodic"]);
+
+    sampler = "sum_tree";
+    if (params.containsElementNamed("sampler"))
+      sampler = Rcpp::as < std::string > (params["sampler"]);
+    if (!RateSampler::IsKnownKind(sampler))
+      Rcpp::stop("Unknown sampler: " + sampler);
+
+    interaction_kernel = "auto";
+    if (params.containsElementNamed("interaction_kernel"))
+      interaction_kernel = Rcpp::as < std::string > (params["interaction_kernel"]);
+    if (!InteractionKernel::IsKnownKind(interaction_kernel))
+      Rcpp::stop("Unknown interaction kernel: " + interaction_kernel);
+    if (!InteractionKernel::IsSupported(interaction_kernel))
+      Rcpp::stop("Interaction kernel " + interaction_kernel + " is not supported by this CPU");
+
+    sorted_cells = false;
+    if (params.containsElementNamed("sorted_cells"))
+      sorted_cells = Rcpp::as < bool > (params["sorted_cells"]);
+
+    cell_order = "row_major";
+    if (params.containsElementNamed("cell_order"))
+      cell_order = Rcpp::as < std::string > (params["cell_order"]);
+    if (!CellOrder::IsKnownKind(cell_order))
+      Rcpp::stop("Unknown cell order: " + cell_order);
+
+    threads = 1;
+    if (params.containsElementNamed("threads"))
+      threads = Rcpp::as < int > (params["threads"]);
+    if (threads < 1)
+      Rcpp::stop("threads must be positive");
+
+    realtime_limit = Rcpp::as<double>(params["realtime_limit"]);
+
+    death_kernel = "spline";
+    if (params.containsElementNamed("death_kernel"))
+      death_kernel = Rcpp::as < std::string > (params["death_kernel"]);
+    if (death_kernel != "spline" && death_kernel != "table")
+      Rcpp::stop("Unknown death kernel: " + death_kernel);
+
+    death_kernel_tolerance = 1e-6;
+    if (params.containsElementNamed("death_kernel_tolerance"))
+      death_kernel_tolerance = Rcpp::as < double > (params["death_kernel_tolerance"]);
+    if (death_kernel == "table" && !(death_kernel_tolerance > 0))
+      Rcpp::stop("death_kernel_tolerance must be positive");
+
+    auto_cell_count = false;
+    if (params.containsElementNamed("auto_cell_count"))
+      auto_cell_count = Rcpp::as < bool > (params["auto_cell_count"]);
+    cell_occupancy = 6;
+    if (params.containsElementNamed("cell_occupancy"))
+      cell_occupancy = Rcpp::as < double > (params["cell_occupancy"]);
+    if (!(cell_occupancy > 0))
+      Rcpp::stop("cell_occupancy must be positive");
+    if (!auto_cell_count) {
+      for (int axis = 0; axis < dim; axis++)
+        cell_count[axis] = Rcpp::as < int > (params["cell_count_" + axis_name(axis)]);
+    }
+
+    neighbour_lists = false;
+    if (params.containsElementNamed("neighbour_lists"))
+      neighbour_lists = Rcpp::as < bool > (params["neighbour_lists"]);
+    neighbour_list_budget = 1e9;
+    if (params.containsElementNamed("neighbour_list_budget"))
+      neighbour_list_budget = Rcpp::as < double > (params["neighbour_list_budget"]);
+    if (!(neighbour_list_budget > 0))
+      Rcpp::stop("neighbour_list_budget must be positive");
+
+    tau_leaping = false;
+    if (params.containsElementNamed("tau_leaping"))
+      tau_leaping = Rcpp::as < bool > (params["tau_leaping"]);
+    tau_epsilon = 0.03;
+    if (params.containsElementNamed("tau_epsilon"))
+      tau_epsilon = Rcpp::as < double > (params["tau_epsilon"]);
+    if (!(tau_epsilon > 0))
+      Rcpp::stop("tau_epsilon must be positive");
+    tau_ssa_events = 100;
+    if (params.containsElementNamed("tau_ssa_events"))
+      tau_ssa_events = Rcpp::as < int > (params["tau_ssa_events"]);
+    if (tau_ssa_events < 1)
+      Rcpp::stop("tau_ssa_events must be positive");
+  }
+};
+
+//Simulator shared by poisson_1d, poisson_2d and poisson_3d. Axes are numbered
+//0, 1, 2 for x, y, z. The event loop is instantiated for each boundary mode,
+//so hot paths are compiled once per dimension and mode.
+template < int Dim >
+struct Grid_nd {
+  //Coordinates and death rates of all specimens, stored contiguously by cell
+  SpecimenArena < Dim > cells;
+  //Mirrors death rates within each cell for O(log k) selection of the dying specimen
+  std::vector < SumTree > in_cell_death_rates;
+
+  std::vector < double > cell_death_rates;
+  std::vector < int > cell_population;
+  OccupancyBitmap occupied_cells;
+
+  //Mirrors cell_death_rates for death cell selection, see rate_sampler.h
+  std::string sampler;
+  RateSampler cell_death_rate_sampler;
+
+  //Flat index of all specimens for uniform parent selection
+  SpecimenIndex specimens;
+
+  double area_length[Dim];
+
+  bool periodic;
+
+  //Cell (i, j, k) is at row-major position i * cell_stride[0] + j * cell_stride[1] + k * cell_stride[2]
+  int cell_count[Dim];
+  int cell_stride[Dim];
+
+  //Storage order of cells, see cell_order.h. Unless it is "row_major", the cell
+  //at each row-major position is cell_at_row_major[position] and cell_row_major
+  //maps it back, otherwise both are empty and the position is the cell index.
+  std::string cell_order;
+  std::vector < int > cell_at_row_major;
+  std::vector < int > cell_row_major;
+
+  int cull[Dim];
+
+  //Cells within the cull distance of each cell, see cell_blocks.h
+  CellStencils < Dim > stencils;
+
+  //Distance scan of collect_neighbours, see interaction_kernel.h
+  std::string interaction_kernel;
+  InteractionKernel neighbour_scan;
+
+  //Worker threads of sweep_blocks, 1 unless asked for
+  int threads;
+
+  //With sorted_cells specimens of each cell are kept in increasing x, births are
+  //inserted in place and deaths close the gap, so neighbour scans only measure
+  //the specimens within death_cutoff_r along x, found by binary search
+  bool sorted_cells;
+
+  //With auto_cell_count cells are sized for about cell_occupancy specimens each,
+  //but never narrower than death_cutoff_r. The grid is rebuilt by regrid once the
+  //population leaves [regrid_population_low, regrid_population_high], which takes
+  //at least half as many events as there are specimens, so the O(n) rebuild is
+  //amortised to O(1) per event. regrid_seconds is the time spent rebuilding.
+  bool auto_cell_count;
+  double cell_occupancy;
+  int regrid_population_low;
+  int regrid_population_high;
+  int regrid_count;
+  double regrid_seconds;
+
+  //With neighbour_lists every specimen has an id, and neighbour_links holds for it
+  //the specimens within death_cutoff_r with the interaction added to both, so a
+  //death subtracts stored interactions without measuring a distance or evaluating
+  //the kernel. specimen_at locates each id and cell_ids lists the ids of a cell by
+  //slot. Once neighbour_list_memory would pass neighbour_list_budget bytes the
+  //lists are dropped for the rest of the run and neighbour_lists turns off.
+  //A birth still measures its neighbours and writes to each of their lists,
+  //which are scattered in memory, so the lists pay off when cells hold many more
+  //specimens than are within death_cutoff_r, not with cells about that wide.
+  bool neighbour_lists;
+  double neighbour_list_budget;
+  NeighbourLists neighbour_links;
+  std::vector < SpecimenHandle > specimen_at;
+  std::vector < std::vector < int > > cell_ids;
+  //Slots of each cell a listed death changed, -1 for cells it did not change
+  std::vector < int > changed_first;
+  std::vector < int > changed_last;
+  std::vector < int > changed_cells;
+  //Neighbours a birth links to the new specimen at once, see NeighbourLists::Connect
+  std::vector < int > new_neighbour_ids;
+  std::vector < double > new_neighbour_interactions;
+
+  //With tau_leaping time advances in leaps, over each of which the births and
+  //deaths of every cell are Poisson numbers drawn from the rates at its start,
+  //see leap. Leaps are sized so that no cell population is expected to change
+  //by more than tau_epsilon of itself, and when that leaves fewer than
+  //tau_ssa_events events for a leap, as in small or sparse populations,
+  //tau_ssa_events exact events are made instead. leaps and leap_events count
+  //the leaps and the events made in them.
+  bool tau_leaping;
+  double tau_epsilon;
+  int tau_ssa_events;
+  int leaps;
+  int leap_events;
+  //Offspring coordinates and dying specimens of a leap
+  std::vector < double > leap_offspring[Dim];
+  std::vector < SpecimenHandle > leap_victims;
+  //Set during the batch of a leap, see sum_cell_rates, with the cells whose
+  //sums are left to its end
+  bool leaping;
+  std::vector < char > leap_changed;
+  std::vector < int > leap_changed_cells;
+
+  //Scratch space of collect_neighbours
+  std::vector < int > neighbour_end;
+  std::vector < int > neighbour_slots;
+  std::vector < double > neighbour_squared_distances;
+
+  double b, d, dd;
+  int seed;
+  boost::random::lagged_fibonacci2281 rng;
+
+  std::vector < double > initial_population[Dim];
+
+  int total_population;
+
+  std::chrono::system_clock::time_point init_time;
+  double realtime_limit;
+  bool realtime_limit_reached;
+
+  double total_death_rate;
+
+  double time;
+  int event_count;
+
+  std::vector<double> death_y;
+  double death_cutoff_r;
+  double death_step;
+  int death_spline_nodes;
+  boost::math::interpolators::cardinal_cubic_b_spline<double> death_spline;
+
+  //"spline" evaluates death_spline per pair, "table" looks dd * death_spline
+  //up by squared distance within death_kernel_tolerance of the spline
+  std::string death_kernel;
+  bool death_tabulated;
+  double death_kernel_tolerance;
+  double death_kernel_max_error;
+  KernelTable death_table;
+
+  std::vector<double> birth_inverse_rcdf_y;
+  double birth_inverse_rcdf_step;
+  int birth_inverse_rcdf_nodes;
+  boost::math::interpolators::cardinal_cubic_b_spline<double> birth_inverse_rcdf_spline;
+
+  int cell_count_total() const {
+    return cell_stride[Dim - 1] * cell_count[Dim - 1];
+  }
+
+  int cell_index(const int * index) const {
+    int position = 0;
+    for (int axis = 0; axis < Dim; axis++)
+      position += index[axis] * cell_stride[axis];
+    return cell_at_row_major.empty() ? position : cell_at_row_major[position];
+  }
+
+  void grid_index(int cell, int * index) const {
+    int position = cell_row_major.empty() ? cell : cell_row_major[cell];
+    for (int axis = 0; axis < Dim; axis++)
+      index[axis] = position / cell_stride[axis] % cell_count[axis];
+  }
+
+  void set_cell_counts(const int * counts) {
+    for (int axis = 0; axis < Dim; axis++) {
+      cell_count[axis] = counts[axis];
+      cell_stride[axis] = axis == 0 ? 1 : cell_stride[axis - 1] * cell_count[axis - 1];
+      //Amount of cells to check around for death interaction
+      cull[axis] = static_cast < int > (ceil(death_cutoff_r / (area_length[axis] / cell_count[axis])));
+    }
+
+    cell_at_row_major.clear();
+    cell_row_major.clear();
+    if (cell_order != "row_major" && Dim > 1) {
+      cell_row_major = CellOrder::RowMajorIndices(cell_order, cell_count, Dim);
+      cell_at_row_major.resize(cell_count_total());
+      for (int cell = 0; cell < cell_count_total(); cell++)
+        cell_at_row_major[cell_row_major[cell]] = cell;
+    }
+  }
+
+  //Cells per axis for the population with auto_cell_count, as many as fit in the
+  //area with cell_occupancy specimens per cell at the mean density
+  void auto_cell_counts(int population, int * counts) const {
+    double volume = 1;
+    for (int axis = 0; axis < Dim; axis++)
+      volume *= area_length[axis];
+    double side = death_cutoff_r;
+    if (population > 0)
+      side = std::max(side, pow(cell_occupancy * volume / population, 1.0 / Dim));
+    for (int axis = 0; axis < Dim; axis++)
+      counts[axis] = population > 0 ? std::max(1, static_cast < int > (floor(area_length[axis] / side))) : 1;
+  }
+
+  int cell_of(const double * coords) const {
+    int index[Dim];
+    for (int axis = 0; axis < Dim; axis++) {
+      index[axis] = static_cast < int > (floor(coords[axis] * cell_count[axis] / area_length[axis]));
+      if (index[axis] == cell_count[axis]) index[axis]--;
+    }
+    return cell_index(index);
+  }
+
+  double interaction_at(double squared_distance) const {
+    if (death_tabulated)
+      return death_table(squared_distance);
+    return dd * death_spline(sqrt(squared_distance));
+  }
+
+  //Slots [first, last) of the cell that can be within death_cutoff_r along x of
+  //a point at x, all of them unless cells are sorted. The window is a little
+  //wider than the cutoff, as x is compared without the shift rounding of the scan.
+  void x_window(int cell, double x, int & first, int & last) const {
+    if (!sorted_cells) return;
+    const double reach = death_cutoff_r * (1 + 1e-9);
+    const double * xs = cells.Coords(0, cell);
+    first = std::lower_bound(xs + first, xs + last, x - reach) - xs;
+    last = std::upper_bound(xs + first, xs + last, x + reach) - xs;
+  }
+
+  //Finds specimens within death_cutoff_r of the point in the stencil of cell owner,
+  //leaving out slot skip of the owner itself. Slots and squared distances of the
+  //specimens found in the e-th stencil cell end at neighbour_end[e] in
+  //neighbour_slots and neighbour_squared_distances.
+  void collect_neighbours(const double * point, int owner, int skip) {
+    stencils.Collect(neighbour_scan, point, owner, skip, death_cutoff_r * death_cutoff_r,
+                     [&](int cell, double x, int & first, int & last, const double ** coords) {
+      if (!occupied_cells.Test(cell))
+        return false;
+      first = 0;
+      last = cells.CellSize(cell);
+      x_window(cell, x, first, last);
+      for (int axis = 0; axis < Dim; axis++)
+        coords[axis] = cells.Coords(axis, cell);
+      return true;
+    }, neighbour_end, neighbour_slots, neighbour_squared_distances);
+  }
+
+  void build_stencils() {
+    stencils.Build(cell_count, area_length, cull, death_cutoff_r, periodic, cell_row_major, cell_at_row_major);
+  }
+
+  std::vector < double > get_coords_at_cell(int axis, int cell) {
+    return std::vector < double > (cells.Coords(axis, cell), cells.Coords(axis, cell) + cells.CellSize(cell));
+  }
+
+  std::vector < double > get_death_rates_at_cell(int cell) {
+    return std::vector < double > (cells.DeathRates(cell), cells.DeathRates(cell) + cells.CellSize(cell));
+  }
+
+  std::vector < double > get_all_coords(int axis) {
+    std::vector < double > result;
+    result.reserve(total_population);
+    for (int cell = occupied_cells.Next(0, cells.CellCount()); cell < cells.CellCount(); cell = occupied_cells.Next(cell + 1, cells.CellCount())) {
+      result.insert(result.end(), cells.Coords(axis, cell), cells.Coords(axis, cell) + cells.CellSize(cell));
+    }
+    return result;
+  }
+
+  std::vector < double > get_all_death_rates() {
+    std::vector < double > result;
+    result.reserve(total_population);
+    for (int cell = occupied_cells.Next(0, cells.CellCount()); cell < cells.CellCount(); cell = occupied_cells.Next(cell + 1, cells.CellCount())) {
+      result.insert(result.end(), cells.DeathRates(cell), cells.DeathRates(cell) + cells.CellSize(cell));
+    }
+    return result;
+  }
+
+  //Adds the interactions of every unordered pair with one specimen in the cell
+  //to both death rates. The other specimen is later in the cell or in the half
+  //of the stencil after the cell itself, which holds the positive offsets.
+  //Stencil cells are taken one at a time against the whole cell, so both stay in cache.
+  void sweep_cell(int cell, std::vector < int > & slots, std::vector < double > & squared_distances) {
+    const double cutoff_squared = death_cutoff_r * death_cutoff_r;
+    int size = cells.CellSize(cell);
+    double * death_rates = cells.DeathRates(cell);
+    if (size == 0)
+      return;
+
+    for (int s = stencils.Self(cell); s < stencils.End(cell); s++) {
+      int other = stencils.Cell(s);
+      double * other_death_rates = cells.DeathRates(other);
+      double shift[Dim];
+      const double * coords[Dim];
+      for (int axis = 0; axis < Dim; axis++)
+        shift[axis] = stencils.Shift(axis, s);
+
+      for (int k = 0; k < size; k++) {
+        double point[Dim];
+        for (int axis = 0; axis < Dim; axis++)
+          point[axis] = cells.Coords(axis, cell)[k];
+
+        //Within the cell only specimens after k are paired with it
+        int first = s == stencils.Self(cell) ? k + 1 : 0, last = cells.CellSize(other);
+        x_window(other, point[0] + shift[0], first, last);
+        int count = last - first;
+        for (int axis = 0; axis < Dim; axis++)
+          coords[axis] = cells.Coords(axis, other) + first;
+        if (static_cast < int > (slots.size()) < count + InteractionKernel::Padding) {
+          slots.resize(2 * (count + InteractionKernel::Padding));
+          squared_distances.resize(2 * (count + InteractionKernel::Padding));
+        }
+
+        int found = neighbour_scan.Scan < Dim > (point, coords, shift, count, cutoff_squared, -1,
+                                                 slots.data(), squared_distances.data());
+        for (int n = 0; n < found; n++) {
+          double interaction = interaction_at(squared_distances[n]);
+          death_rates[k] += interaction;
+          other_death_rates[first + slots[n]] += interaction;
+        }
+      }
+    }
+  }
+
+  //Sweeps all cells with sweep_cell, block by block, see CellBlocks. Blocks of
+  //one colour never write to the same cell, so they run in parallel, while every
+  //death rate is summed in the same order whatever the number of threads.
+  void sweep_blocks() {
+    CellBlocks < Dim > blocks(cell_count, cull, std::numeric_limits < int > ::max(), cell_row_major);
+    WorkerPool workers(threads);
+    for (int colour = 0; colour < blocks.ColourCount(); colour++) {
+      const std::vector < int > & colour_blocks = blocks.Colour(colour);
+      workers.Run(colour_blocks.size(), [&](int i) {
+        std::vector < int > slots;
+        std::vector < double > squared_distances;
+        for (int cell : blocks.Cells(colour_blocks[i]))
+          sweep_cell(cell, slots, squared_distances);
+      });
+    }
+  }
+
+  void clear_cells() {
+    cells = SpecimenArena < Dim > (cell_count_total());
+    in_cell_death_rates.assign(cell_count_total(), SumTree());
+    cell_death_rates.assign(cell_count_total(), 0);
+    cell_population.assign(cell_count_total(), 0);
+    specimens = SpecimenIndex(1, cell_count_total());
+    occupied_cells = OccupancyBitmap(cell_count_total());
+    if (neighbour_lists) {
+      cell_ids.assign(cell_count_total(), std::vector < int > ());
+      changed_first.assign(cell_count_total(), -1);
+      changed_last.assign(cell_count_total(), -1);
+    }
+  }
+
+  //Heap memory of the neighbour lists and of the ids that locate specimens, in bytes
+  double neighbour_list_memory() const {
+    if (!neighbour_lists)
+      return 0;
+    return neighbour_links.Bytes() +
+      static_cast < double > (specimen_at.capacity()) * (sizeof(SpecimenHandle) + sizeof(int)) +
+      static_cast < double > (cell_ids.size()) * (sizeof(std::vector < int >) + 2 * sizeof(int));
+  }
+
+  void drop_neighbour_lists() {
+    neighbour_lists = false;
+    neighbour_links = NeighbourLists();
+    std::vector < SpecimenHandle > ().swap(specimen_at);
+    std::vector < std::vector < int > > ().swap(cell_ids);
+    std::vector < int > ().swap(changed_first);
+    std::vector < int > ().swap(changed_last);
+    std::vector < int > ().swap(changed_cells);
+  }
+
+  //Gives the id the slot, moving the ids after it up by one
+  void place_id(int cell, int slot, int id) {
+    std::vector < int > & ids = cell_ids[cell];
+    ids.insert(ids.begin() + slot, id);
+    if (static_cast < int > (specimen_at.size()) <= id)
+      specimen_at.resize(id + 1);
+    for (int k = slot; k < static_cast < int > (ids.size()); k++)
+      specimen_at[ids[k]] = SpecimenHandle{cell, k};
+  }
+
+  //Frees the id of the specimen at the slot, the ids of the cell follow the
+  //slots as cells.Remove or cells.Erase moved them
+  void forget_id(int cell, int slot) {
+    std::vector < int > & ids = cell_ids[cell];
+    neighbour_links.Remove(ids[slot]);
+    if (sorted_cells) {
+      ids.erase(ids.begin() + slot);
+    } else {
+      ids[slot] = ids.back();
+      ids.pop_back();
+    }
+    int last = sorted_cells ? ids.size() : std::min < int > (slot + 1, ids.size());
+    for (int k = slot; k < last; k++)
+      specimen_at[ids[k]].Slot = k;
+  }
+
+  //Puts a specimen into the cell, in x order with sorted_cells, and returns its slot.
+  //id is that of neighbour_links, ignored without neighbour_lists.
+  int insert_specimen(int cell, const double * coords, double death_rate, int id) {
+    int k;
+    if (!sorted_cells) {
+      k = cells.Add(cell, coords, death_rate);
+      specimens.Add(cell, 0);
+    } else {
+      const double * xs = cells.Coords(0, cell);
+      k = std::upper_bound(xs, xs + cells.CellSize(cell), coords[0]) - xs;
+      cells.Insert(cell, k, coords, death_rate);
+      specimens.Insert(cell, k, 0, cells.Species(cell));
+    }
+    if (neighbour_lists)
+      place_id(cell, k, id);
+    return k;
+  }
+
+  void add_specimen(const double * coords, double death_rate, int id) {
+    int cell = cell_of(coords);
+    insert_specimen(cell, coords, death_rate, id);
+    cell_population[cell]++;
+    occupied_cells.Set(cell);
+  }
+
+  //Cell rates are summed afresh, so they do not depend on the order specimens were added in.
+  //Rates and trees of empty cells are left as clear_cells made them.
+  void sum_cell_rates() {
+    for (int cell = occupied_cells.Next(0, cell_count_total()); cell < cell_count_total(); cell = occupied_cells.Next(cell + 1, cell_count_total())) {
+      const double * death_rates = cells.DeathRates(cell);
+      cell_death_rates[cell] = std::accumulate(death_rates, death_rates + cells.CellSize(cell), 0.0);
+      in_cell_death_rates[cell].Build(get_death_rates_at_cell(cell));
+    }
+    cell_death_rate_sampler.Build(cell_death_rates);
+  }
+
+  void Initialize_death_rates() {
+
+    clear_cells();
+
+    //Spawn all speciments
+    for (int sp_index = 0; sp_index < static_cast < int > (initial_population[0].size()); sp_index++) {
+      double coords[Dim];
+      bool inside = true;
+      for (int axis = 0; axis < Dim; axis++) {
+        coords[axis] = initial_population[axis][sp_index];
+        if (coords[axis] < 0 || coords[axis] > area_length[axis]) inside = false;
+      }
+      if (!inside) continue;
+
+      add_specimen(coords, d, neighbour_lists ? neighbour_links.Add() : -1);
+      total_population++;
+    }
+    //Lay cells out in order before the sweep
+    cells.Repack();
+
+    sweep_blocks();
+    sum_cell_rates();
+    if (neighbour_lists)
+      link_all_neighbours();
+  }
+
+  //Links every pair within death_cutoff_r once, from the specimen with the smaller
+  //id, giving up on the lists as soon as they pass neighbour_list_budget
+  void link_all_neighbours() {
+    for (int cell = occupied_cells.Next(0, cell_count_total()); cell < cell_count_total(); cell = occupied_cells.Next(cell + 1, cell_count_total())) {
+      for (int k = 0; k < cells.CellSize(cell); k++) {
+        double point[Dim];
+        for (int axis = 0; axis < Dim; axis++)
+          point[axis] = cells.Coords(axis, cell)[k];
+        collect_neighbours(point, cell, k);
+
+        int id = cell_ids[cell][k];
+        int n = 0;
+        for (int s = stencils.Begin(cell); s < stencils.End(cell); s++) {
+          const std::vector < int > & other_ids = cell_ids[stencils.Cell(s)];
+          for (int end = neighbour_end[s - stencils.Begin(cell)]; n < end; n++) {
+            int other_id = other_ids[neighbour_slots[n]];
+            if (other_id > id)
+              neighbour_links.Connect(id, other_id, interaction_at(neighbour_squared_distances[n]));
+          }
+        }
+        if (neighbour_list_memory() > neighbour_list_budget) {
+          drop_neighbour_lists();
+          return;
+        }
+      }
+    }
+  }
+
+  //Moves all specimens to a grid with the given cell counts. Death rates do not
+  //depend on the grid, so they are carried over rather than recomputed.
+  void regrid(const int * counts) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector < double > coords[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      coords[axis] = get_all_coords(axis);
+    std::vector < double > death_rates = get_all_death_rates();
+    std::vector < int > ids;
+    if (neighbour_lists) {
+      for (int cell = occupied_cells.Next(0, cells.CellCount()); cell < cells.CellCount(); cell = occupied_cells.Next(cell + 1, cells.CellCount()))
+        ids.insert(ids.end(), cell_ids[cell].begin(), cell_ids[cell].end());
+    }
+
+    set_cell_counts(counts);
+    build_stencils();
+    clear_cells();
+    for (int i = 0; i < static_cast < int > (death_rates.size()); i++) {
+      double point[Dim];
+      for (int axis = 0; axis < Dim; axis++)
+        point[axis] = coords[axis][i];
+      add_specimen(point, death_rates[i], neighbour_lists ? ids[i] : -1);
+    }
+    cells.Repack();
+    sum_cell_rates();
+    total_death_rate = std::accumulate(cell_death_rates.begin(), cell_death_rates.end(), 0.0);
+
+    regrid_count++;
+    regrid_seconds += std::chrono::duration < double > (std::chrono::steady_clock::now() - start).count();
+  }
+
+  //Resizes cells for the current population, if it changed them, and moves the
+  //population window to between half and twice the current population
+  void adapt_cells() {
+    int counts[Dim];
+    auto_cell_counts(total_population, counts);
+    if (!std::equal(counts, counts + Dim, cell_count))
+      regrid(counts);
+    regrid_population_low = total_population / 2;
+    regrid_population_high = std::max(2 * total_population, 1);
+  }
+
+  //Passes the death rate of the cell to the sampler, or during a leap marks the
+  //cell to be passed once at its end
+  void cell_rate_changed(int cell) {
+    if (!leaping) {
+      cell_death_rate_sampler.Set(cell, cell_death_rates[cell]);
+    } else if (!leap_changed[cell]) {
+      leap_changed[cell] = true;
+      leap_changed_cells.push_back(cell);
+    }
+  }
+
+  //Sums the tree of the cell over the slots set in it, then passes its rate on.
+  //During a leap the whole tree is summed at its end instead, cells near many
+  //of its births and deaths being summed once rather than once for each.
+  void sum_cell_rates(int cell, int first_slot, int last_slot) {
+    if (!leaping)
+      in_cell_death_rates[cell].SumLeaves(first_slot, last_slot);
+    cell_rate_changed(cell);
+  }
+
+  //Takes the interactions of the specimen at the slot off its neighbours and the
+  //cells, which are found by measuring distances as at its birth
+  void release_measured_neighbours(int cell_death_index, int in_cell_death_index) {
+    double point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      point[axis] = cells.Coords(axis, cell_death_index)[in_cell_death_index];
+
+    collect_neighbours(point, cell_death_index, in_cell_death_index);
+
+    int n = 0;
+    for (int s = stencils.Begin(cell_death_index); s < stencils.End(cell_death_index); s++) {
+      int cell = stencils.Cell(s);
+      int end = neighbour_end[s - stencils.Begin(cell_death_index)];
+      //Rates of cells without neighbours are unchanged
+      if (n == end) continue;
+
+      //Slots come out of the scan in increasing order, so the tree of the cell
+      //is summed once over the range they span
+      double * death_rates = cells.DeathRates(cell);
+      SumTree & rates = in_cell_death_rates[cell];
+      int first_slot = neighbour_slots[n];
+      for (; n < end; n++) {
+        int k = neighbour_slots[n];
+        double interaction = interaction_at(neighbour_squared_distances[n]);
+
+        death_rates[k] -= interaction;
+        rates.SetLeaf(k, death_rates[k]);
+        //ignore dying speciment death rates since it is to be deleted
+
+        cell_death_rates[cell] -= interaction;
+        cell_death_rates[cell_death_index] -= interaction;
+
+        total_death_rate -= 2 * interaction;
+      }
+      sum_cell_rates(cell, first_slot, neighbour_slots[end - 1]);
+    }
+  }
+
+  //Same as release_measured_neighbours, but neighbours and interactions are read
+  //from the list of the specimen
+  void release_listed_neighbours(int cell_death_index, int in_cell_death_index) {
+    const std::vector < NeighbourLists::Link > & links = neighbour_links.Of(cell_ids[cell_death_index][in_cell_death_index]);
+    //Neighbours are scattered in memory, so they are fetched a few links ahead
+    const int ahead = 8;
+    const int count = static_cast < int > (links.size());
+    for (int i = 0; i < count; i++) {
+      if (i + 2 * ahead < count)
+        __builtin_prefetch(&specimen_at[links[i + 2 * ahead].Id]);
+      if (i + ahead < count) {
+        SpecimenHandle next = specimen_at[links[i + ahead].Id];
+        __builtin_prefetch(cells.DeathRates(next.Cell) + next.Slot, 1);
+      }
+      const NeighbourLists::Link & link = links[i];
+      //Entries of neighbours that died before are stale
+      if (!neighbour_links.Live(link)) continue;
+      SpecimenHandle at = specimen_at[link.Id];
+      double * death_rates = cells.DeathRates(at.Cell);
+      death_rates[at.Slot] -= link.Interaction;
+      in_cell_death_rates[at.Cell].SetLeaf(at.Slot, death_rates[at.Slot]);
+      if (changed_first[at.Cell] < 0) {
+        changed_cells.push_back(at.Cell);
+        changed_first[at.Cell] = changed_last[at.Cell] = at.Slot;
+      } else {
+        changed_first[at.Cell] = std::min(changed_first[at.Cell], at.Slot);
+        changed_last[at.Cell] = std::max(changed_last[at.Cell], at.Slot);
+      }
+
+      cell_death_rates[at.Cell] -= link.Interaction;
+      cell_death_rates[cell_death_index] -= link.Interaction;
+
+      total_death_rate -= 2 * link.Interaction;
+    }
+    //Neighbours are in no particular order, the tree of each cell is summed once
+    //over the range of slots changed in it
+    for (int cell : changed_cells) {
+      sum_cell_rates(cell, changed_first[cell], changed_last[cell]);
+      changed_first[cell] = -1;
+    }
+    changed_cells.clear();
+  }
+
+  void kill_random() {
+
+    if (total_population == 1) {
+      total_population--;
+      return;
+    }
+
+    int cell_death_index = cell_death_rate_sampler.Sample(rng);
+    SumTree & death_cell_rates = in_cell_death_rates[cell_death_index];
+
+    int in_cell_death_index = death_cell_rates.Find(boost::random::uniform_01 < > ()(rng) * death_cell_rates.Total());
+
+    remove_specimen(cell_death_index, in_cell_death_index);
+  }
+
+  //Takes the specimen at the slot out with its interactions
+  void remove_specimen(int cell_death_index, int in_cell_death_index) {
+    SumTree & death_cell_rates = in_cell_death_rates[cell_death_index];
+
+    if (neighbour_lists)
+      release_listed_neighbours(cell_death_index, in_cell_death_index);
+    else
+      release_measured_neighbours(cell_death_index, in_cell_death_index);
+
+    //remove dead speciment
+    cell_death_rates[cell_death_index] -= d;
+    total_death_rate -= d;
+
+    if (std::abs(cell_death_rates[cell_death_index]) < 1e-10) {
+      cell_death_rates[cell_death_index] = 0;
+    }
+    cell_rate_changed(cell_death_index);
+
+    cell_population[cell_death_index]--;
+    total_population--;
+    if (cell_population[cell_death_index] == 0)
+      occupied_cells.Clear(cell_death_index);
+
+    if (sorted_cells) {
+      cells.Erase(cell_death_index, in_cell_death_index);
+      specimens.Erase(cell_death_index, in_cell_death_index, 0, cells.Species(cell_death_index));
+      death_cell_rates.Erase(in_cell_death_index);
+    } else {
+      //swap dead and last
+      specimens.Remove(cell_death_index, in_cell_death_index, 0, 0);
+      cells.Remove(cell_death_index, in_cell_death_index);
+      death_cell_rates.SwapWithLast(in_cell_death_index);
+      death_cell_rates.Pop();
+    }
+    if (neighbour_lists)
+      forget_id(cell_death_index, in_cell_death_index);
+  }
+
+  template < bool Periodic >
+  void spawn_random() {
+    //Parent is chosen uniformly among all specimens
+    SpecimenHandle parent = specimens.Sample(rng, 0);
+
+    double point[Dim];
+    if (offspring_of < Periodic > (parent, point))
+      insert_offspring(point);
+  }
+
+  //Draws where an offspring of the parent lands, false if outside the area
+  template < bool Periodic >
+  bool offspring_of(SpecimenHandle parent, double * point) {
+    double at[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      at[axis] = cells.Coords(axis, parent.Cell)[parent.Slot];
+    return offspring_near < Periodic > (at, point);
+  }
+
+  //Same as offspring_of, for a parent at the point at
+  template < bool Periodic >
+  bool offspring_near(const double * at, double * point) {
+    draw_offspring < Dim > (birth_inverse_rcdf_spline, rng, at, point);
+
+    for (int axis = 0; axis < Dim; axis++) {
+      //Specimen failed to spawn and died outside area boundaries
+      if (!Boundary < Periodic > ::place(point[axis], area_length[axis])) return false;
+    }
+    return true;
+  }
+
+  //Puts a new specimen at the point and adds its interactions
+  void insert_offspring(const double * point) {
+    //New speciment is added to the end of its cell, or in x order
+    int new_cell = cell_of(point);
+    int new_id = neighbour_lists ? neighbour_links.Add() : -1;
+    int new_k = insert_specimen(new_cell, point, d, new_id);
+    in_cell_death_rates[new_cell].Insert(new_k, d);
+
+    cell_death_rates[new_cell] += d;
+    total_death_rate += d;
+
+    cell_population[new_cell]++;
+    total_population++;
+    occupied_cells.Set(new_cell);
+
+    collect_neighbours(point, new_cell, new_k);
+    double new_death_rate = d;
+
+    int n = 0;
+    for (int s = stencils.Begin(new_cell); s < stencils.End(new_cell); s++) {
+      int cell = stencils.Cell(s);
+      int end = neighbour_end[s - stencils.Begin(new_cell)];
+      if (n == end) continue;
+
+      double * death_rates = cells.DeathRates(cell);
+      SumTree & rates = in_cell_death_rates[cell];
+      int first_slot = neighbour_slots[n];
+      for (; n < end; n++) {
+        int k = neighbour_slots[n];
+        double interaction = interaction_at(neighbour_squared_distances[n]);
+
+        death_rates[k] += interaction;
+        rates.SetLeaf(k, death_rates[k]);
+        new_death_rate += interaction;
+        if (neighbour_lists) {
+          new_neighbour_ids.push_back(cell_ids[cell][k]);
+          new_neighbour_interactions.push_back(interaction);
+        }
+
+        cell_death_rates[cell] += interaction;
+        cell_death_rates[new_cell] += interaction;
+
+        total_death_rate += 2 * interaction;
+      }
+      sum_cell_rates(cell, first_slot, neighbour_slots[end - 1]);
+    }
+    //The new specimen is left out of the neighbours, its rate is set once all are in
+    cells.DeathRates(new_cell)[new_k] = new_death_rate;
+    in_cell_death_rates[new_cell].Set(new_k, new_death_rate);
+    cell_rate_changed(new_cell);
+
+    if (neighbour_lists) {
+      neighbour_links.Connect(new_id, new_neighbour_ids.data(), new_neighbour_interactions.data(), new_neighbour_ids.size());
+      new_neighbour_ids.clear();
+      new_neighbour_interactions.clear();
+      if (neighbour_list_memory() > neighbour_list_budget)
+        drop_neighbour_lists();
+    }
+  }
+
+  template < bool Periodic >
+  void next_event() {
+    if (total_population == 0)
+      return;
+    if (auto_cell_count && (total_population < regrid_population_low || total_population > regrid_population_high))
+      adapt_cells();
+    event_count++;
+    time += boost::random::exponential_distribution < > (total_population * b + total_death_rate)(rng);
+    //Rolling event according to global birth \ death rate
+    if (boost::random::bernoulli_distribution < > (total_population * b / (total_population * b + total_death_rate))(rng) == 0) {
+      kill_random();
+    } else {
+      spawn_random < Periodic > ();
+    }
+  }
+
+  //Longest leap over which the expected change of each cell population and
+  //its standard deviation stay within tau_epsilon of it, or of one specimen in
+  //sparse cells (Cao, Gillespie and Petzold's step selection, with a cell
+  //population for each species). Offspring are counted in the cell of their
+  //parent, as they mostly land close to it.
+  double leap_step() const {
+    double tau = std::numeric_limits < double > ::infinity();
+    for (int cell = occupied_cells.Next(0, cell_count_total()); cell < cell_count_total(); cell = occupied_cells.Next(cell + 1, cell_count_total())) {
+      double population = cell_population[cell];
+      double bound = std::max(tau_epsilon * population, 1.0);
+      double drift = std::abs(b * population - cell_death_rates[cell]);
+      double variance = b * population + cell_death_rates[cell];
+      if (drift > 0)
+        tau = std::min(tau, bound / drift);
+      if (variance > 0)
+        tau = std::min(tau, bound * bound / variance);
+    }
+    return tau;
+  }
+
+  //Makes the births and deaths of a leap of time tau. Their numbers in each
+  //cell, parents, landing points and dying specimens are all drawn from the
+  //state at the start of the leap, then deaths and births are applied in a
+  //batch, each updating the death rates of its neighbours as in the exact
+  //simulation, so rates stay exact for the specimens after the leap.
+  template < bool Periodic >
+  void leap(double tau) {
+    for (int axis = 0; axis < Dim; axis++)
+      leap_offspring[axis].clear();
+    leap_victims.clear();
+    int events = 0;
+
+    for (int cell = occupied_cells.Next(0, cell_count_total()); cell < cell_count_total(); cell = occupied_cells.Next(cell + 1, cell_count_total())) {
+      int population = cell_population[cell];
+      int births = boost::random::poisson_distribution < > (b * population * tau)(rng);
+      int deaths = 0;
+      if (cell_death_rates[cell] > 0)
+        deaths = std::min(boost::random::poisson_distribution < > (cell_death_rates[cell] * tau)(rng), population);
+      events += births + deaths;
+
+      for (int i = 0; i < births; i++) {
+        SpecimenHandle parent { cell, boost::random::uniform_int_distribution < > (0, population - 1)(rng) };
+        double point[Dim];
+        if (!offspring_of < Periodic > (parent, point)) continue;
+        for (int axis = 0; axis < Dim; axis++)
+          leap_offspring[axis].push_back(point[axis]);
+      }
+
+      //Dying specimens are drawn without replacement by zeroing their leaves,
+      //which are dropped with them
+      SumTree & rates = in_cell_death_rates[cell];
+      for (int i = 0; i < deaths && rates.Total() > 0; i++) {
+        int slot = rates.Find(boost::random::uniform_01 < > ()(rng) * rates.Total());
+        rates.Set(slot, 0);
+        leap_victims.push_back(SpecimenHandle { cell, slot });
+      }
+    }
+
+    //Later slots of a cell go first, so removing one never moves another victim
+    std::sort(leap_victims.begin(), leap_victims.end(), [](const SpecimenHandle & x, const SpecimenHandle & y) {
+      return x.Cell != y.Cell ? x.Cell < y.Cell : x.Slot > y.Slot;
+    });
+    leap_changed.resize(cell_count_total());
+    leaping = true;
+    for (const SpecimenHandle & victim : leap_victims)
+      remove_specimen(victim.Cell, victim.Slot);
+    for (int i = 0; i < static_cast < int > (leap_offspring[0].size()); i++) {
+      double point[Dim];
+      for (int axis = 0; axis < Dim; axis++)
+        point[axis] = leap_offspring[axis][i];
+      insert_offspring(point);
+    }
+    leaping = false;
+    for (int cell : leap_changed_cells) {
+      if (in_cell_death_rates[cell].Count() > 0)
+        in_cell_death_rates[cell].SumLeaves(0, in_cell_death_rates[cell].Count() - 1);
+      cell_death_rate_sampler.Set(cell, cell_death_rates[cell]);
+      leap_changed[cell] = false;
+    }
+    leap_changed_cells.clear();
+
+    time += tau;
+    event_count += events;
+    leap_events += events;
+    leaps++;
+  }
+
+  //Leaps until the time or the event count is reached. Leaps are cut short to
+  //end at the time, and to expect at most half the events left, so the last
+  //events before the count are exact ones and the count is met exactly unless
+  //a leap makes twice its expected events, with a mean of tau_ssa_events or
+  //more as unlikely as 1e-17.
+  template < bool Periodic >
+  void leap_until(double end_time, int end_events) {
+    while (time < end_time && event_count < end_events && total_population > 0) {
+      if (realtime_limit_passed())
+        return;
+      if (auto_cell_count && (total_population < regrid_population_low || total_population > regrid_population_high))
+        adapt_cells();
+
+      double rate = total_population * b + total_death_rate;
+      double tau = std::min(leap_step(), end_time - time);
+      tau = std::min(tau, (static_cast < double > (end_events) - event_count) / 2 / rate);
+      if (tau * rate >= tau_ssa_events) {
+        leap < Periodic > (tau);
+        continue;
+      }
+      for (int i = 0; i < tau_ssa_events && time < end_time && event_count < end_events; i++)
+        next_event < Periodic > ();
+    }
+  }
+
+  bool realtime_limit_passed() {
+    if (std::chrono::system_clock::now() > init_time + std::chrono::duration<double>(realtime_limit)) {
+      realtime_limit_reached = true;
+      return true;
+    }
+    return false;
+  }
+
+  template < bool Periodic >
+  void run_events_with(int events) {
+    if (tau_leaping) {
+      leap_until < Periodic > (std::numeric_limits < double > ::infinity(), event_count + events);
+      return;
+    }
+    for (int i = 0; i < events; i++) {
+      if (realtime_limit_passed())
+        return;
+      next_event < Periodic > ();
+    }
+  }
+
+  template < bool Periodic >
+  void run_for_with(double time) {
+    if (tau_leaping) {
+      leap_until < Periodic > (this->time + time, std::numeric_limits < int > ::max());
+      return;
+    }
+    double time0 = this->time;
+    while (this->time < time0 + time) {
+      if (realtime_limit_passed())
+        return;
+      next_event < Periodic > ();
+    }
+  }
+
+  void make_event() {
+    if (periodic) next_event < true > ();
+    else          next_event < false > ();
+  }
+
+  void run_events(int events) {
+    if (events <= 0)
+      return;
+    if (periodic) run_events_with < true > (events);
+    else          run_events_with < false > (events);
+  }
+
+  void run_for(double time) {
+    if (time <= 0.0)
+      return;
+    if (periodic) run_for_with < true > (time);
+    else          run_for_with < false > (time);
+  }
+
+  double get_death_spline_value(double at) {
+    return death_spline(at);
+  }
+
+  double get_birth_inverse_rcdf_spline_value(double at) {
+    return birth_inverse_rcdf_spline(at);
+  }
+
+  Grid_nd(Rcpp::List params): Grid_nd(Grid_params(params, Dim)) {}
+
+  //Builds the simulator without calling into R, so it may run on any thread.
+  //The parameters were checked when read, only a death kernel table that can
+  //not reach its tolerance throws.
+  Grid_nd(const Grid_params & params): cells(), cell_death_rates(), cell_population(),
+  regrid_count(), regrid_seconds(), leaps(), leap_events(), leaping(),
+  total_population(), realtime_limit_reached(false), total_death_rate(),
+  time(), event_count(), death_spline(), birth_inverse_rcdf_spline() {
+
+    for (int axis = 0; axis < Dim; axis++) {
+      area_length[axis] = params.area_length[axis];
+      initial_population[axis] = params.initial_population[axis];
+    }
+
+    b = params.b;
+    d = params.d;
+    dd = params.dd;
+
+    seed = params.seed;
+    rng = boost::random::lagged_fibonacci2281(uint32_t(seed));
+
+    death_y = params.death_y;
+    death_cutoff_r = params.death_r;
+    death_spline_nodes = death_y.size();
+    death_step = death_cutoff_r / (death_spline_nodes - 1);
+
+    birth_inverse_rcdf_y = params.birth_ircdf_y;
+    birth_inverse_rcdf_nodes = birth_inverse_rcdf_y.size();
+    birth_inverse_rcdf_step = 1.0 / (birth_inverse_rcdf_nodes - 1);
+
+    periodic = params.periodic;
+
+    sampler = params.sampler;
+    cell_death_rate_sampler = RateSampler(sampler);
+
+    neighbour_scan = InteractionKernel(params.interaction_kernel);
+    interaction_kernel = neighbour_scan.Kind();
+
+    sorted_cells = params.sorted_cells;
+    cell_order = params.cell_order;
+    threads = params.threads;
+
+    init_time = std::chrono::system_clock::now();
+    realtime_limit = params.realtime_limit;
+
+    using boost::math::interpolators::cardinal_cubic_b_spline;
+    //Build death spline, ensure 0 derivative at 0 (symmetric) and endpoint (expected no death interaction further)
+    death_spline = cardinal_cubic_b_spline < double > (death_y.begin(), death_y.end(), 0, death_step, 0, 0);
+
+    death_kernel = params.death_kernel;
+    death_tabulated = death_kernel == "table";
+    death_kernel_tolerance = params.death_kernel_tolerance;
+    death_kernel_max_error = 0;
+    if (death_tabulated) {
+      if (!death_table.Build([this](double r) { return death_spline(r); }, death_cutoff_r, dd, death_kernel_tolerance))
+        throw std::runtime_error("Death kernel table can not reach tolerance " + std::to_string(death_kernel_tolerance));
+      death_kernel_max_error = death_table.MaxError();
+    }
+
+    auto_cell_count = params.auto_cell_count;
+    cell_occupancy = params.cell_occupancy;
+
+    neighbour_lists = params.neighbour_lists;
+    neighbour_list_budget = params.neighbour_list_budget;
+
+    tau_leaping = params.tau_leaping;
+    tau_epsilon = params.tau_epsilon;
+    tau_ssa_events = params.tau_ssa_events;
+
+    //Cell counts given are ignored with auto_cell_count
+    int counts[Dim];
+    if (auto_cell_count) {
+      int population = 0;
+      for (int sp_index = 0; sp_index < static_cast < int > (initial_population[0].size()); sp_index++) {
+        bool inside = true;
+        for (int axis = 0; axis < Dim; axis++)
+          inside = inside && initial_population[axis][sp_index] >= 0 && initial_population[axis][sp_index] <= area_length[axis];
+        population += inside;
+      }
+      auto_cell_counts(population, counts);
+    } else {
+      for (int axis = 0; axis < Dim; axis++)
+        counts[axis] = params.cell_count[axis];
+    }
+    set_cell_counts(counts);
+
+    //Build birth inverse rcdf spline, endpoint derivatives not specified
+    birth_inverse_rcdf_spline = cardinal_cubic_b_spline<double>(birth_inverse_rcdf_y.begin(), birth_inverse_rcdf_y.end(), 0, birth_inverse_rcdf_step);
+
+    //Neighbour cells and their periodic shifts are fixed for the grid
+    build_stencils();
+
+    //Spawn speciments and calculate death rates
+    Initialize_death_rates();
+    total_death_rate = std::accumulate(cell_death_rates.begin(), cell_death_rates.end(), 0.0);
+
+    regrid_population_low = 0;
+    regrid_population_high = std::numeric_limits < int > ::max();
+    if (auto_cell_count)
+      adapt_cells();
+  }
+};
+
+//Per-axis fields and methods for the Rcpp modules, which name them by axis
+
+template < int Dim, int Axis >
+double area_length_of(Grid_nd < Dim > * grid) {
+  return grid->area_length[Axis];
+}
+
+template < int Dim, int Axis >
+int cell_count_of(Grid_nd < Dim > * grid) {
+  return grid->cell_count[Axis];
+}
+
+template < int Dim, int Axis >
+int cull_of(Grid_nd < Dim > * grid) {
+  return grid->cull[Axis];
+}
+
+template < int Dim, int Axis >
+std::vector < double > initial_population_of(Grid_nd < Dim > * grid) {
+  return grid->initial_population[Axis];
+}
+
+template < int Dim, int Axis >
+std::vector < double > all_coords_of(Grid_nd < Dim > * grid) {
+  return grid->get_all_coords(Axis);
+}
+
+#endif
@@ -0,0 +1,460 @@
+#include <Rcpp.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <boost/random.hpp>
+#include <boost/random/lagged_fibonacci.hpp>
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/math/interpolators/cardinal_cubic_b_spline.hpp>
+
+#include "coordinate_tree.h"
+#include "spatial_tree.h"
+#include "sparse_grid.h"
+#include "kernel_table.h"
+#include "boundary.h"
+#include "dispersal.h"
+
+#ifndef POISSON_TREE_H
+#define POISSON_TREE_H
+
+//Index of the specimens: a balanced tree ordered by x in 1d, a quadtree or
+//octree in 2d and 3d, or for the sparse simulators a hashed grid of occupied
+//cells. The helpers below give all of them the same calls.
+template < int Dim >
+struct Tree_index {
+  typedef SpatialTree < Dim > type;
+};
+
+template < >
+struct Tree_index < 1 > {
+  typedef CoordinateTree type;
+};
+
+//Builds the index from the parsed parameters of a simulator
+template < class Index >
+struct Index_builder;
+
+template < >
+struct Index_builder < CoordinateTree > {
+  template < class Sim >
+  static CoordinateTree make(const Sim &) {
+    return CoordinateTree();
+  }
+};
+
+template < int Dim >
+struct Index_builder < SpatialTree < Dim > > {
+  template < class Sim >
+  static SpatialTree < Dim > make(const Sim & sim) {
+    return SpatialTree < Dim > (sim.area_length, sim.tree_leaf_size);
+  }
+};
+
+template < int Dim >
+struct Index_builder < SparseGrid < Dim > > {
+  template < class Sim >
+  static SparseGrid < Dim > make(const Sim & sim) {
+    for (int axis = 0; axis < Dim; axis++) {
+      if (sim.cell_count[axis] < 1 || sim.cell_count[axis] > ldexp(1.0, SparseGrid < Dim > ::BitsPerAxis))
+        Rcpp::stop("cell_count must be between 1 and 2^" + std::to_string(SparseGrid < Dim > ::BitsPerAxis) + " per axis");
+    }
+    return SparseGrid < Dim > (sim.area_length, sim.cell_count);
+  }
+};
+
+inline int tree_insert(CoordinateTree & tree, const double * coords, double rate) {
+  return tree.Insert(coords[0], rate);
+}
+
+template < class Index >
+int tree_insert(Index & tree, const double * coords, double rate) {
+  return tree.Insert(coords, rate);
+}
+
+inline double tree_coord(const CoordinateTree & tree, int handle, int) {
+  return tree.Key(handle);
+}
+
+template < class Index >
+double tree_coord(const Index & tree, int handle, int axis) {
+  return tree.Coord(handle, axis);
+}
+
+template < class F >
+void tree_update(CoordinateTree & tree, const double * lo, const double * hi, F update) {
+  tree.Update(lo[0], hi[0], [&](double key, double rate) { return update(&key, rate); });
+}
+
+template < class Index, class F >
+void tree_update(Index & tree, const double * lo, const double * hi, F update) {
+  tree.Update(lo, hi, update);
+}
+
+template < class F >
+void tree_visit(const CoordinateTree & tree, F visit) {
+  tree.Visit([&](double key, double rate) { visit(&key, rate); });
+}
+
+template < class Index, class F >
+void tree_visit(const Index & tree, F visit) {
+  tree.Visit(visit);
+}
+
+//Gridless simulator shared by poisson_1d_tree, poisson_2d_tree and
+//poisson_3d_tree. Specimens live in one tree that sums death rates over
+//subtrees, so the dying specimen, the parent and the neighbours within
+//death_cutoff_r are found without any cell parameters: in O(log N + k) in 1d,
+//and in 2d and 3d in time that follows the local density, as the quadtree or
+//octree refines where specimens cluster. Events are drawn as in the grid
+//simulators, though not from the same random stream, so runs are equal in
+//distribution only.
+//With a SparseGrid index it is poisson_1d_sparse, poisson_2d_sparse or
+//poisson_3d_sparse: cells as in the grid simulators, but only occupied ones
+//exist, so the area may hold far more cells than there are specimens.
+template < int Dim, class Index = typename Tree_index < Dim > ::type >
+struct Tree_nd {
+  Index specimens;
+  //Most specimens a leaf of the 2d and 3d trees holds before it splits
+  int tree_leaf_size;
+  //Cells per axis of the sparse grid
+  int cell_count[Dim];
+
+  double area_length[Dim];
+  std::vector < double > initial_population[Dim];
+  bool periodic;
+
+  double b, d, dd;
+  int seed;
+  boost::random::lagged_fibonacci2281 rng;
+
+  int total_population;
+
+  std::chrono::system_clock::time_point init_time;
+  double realtime_limit;
+  bool realtime_limit_reached;
+
+  //Kept equal to the tree total after every event
+  double total_death_rate;
+
+  double time;
+  int event_count;
+
+  std::vector<double> death_y;
+  double death_cutoff_r;
+  double death_step;
+  int death_spline_nodes;
+  boost::math::interpolators::cardinal_cubic_b_spline<double> death_spline;
+
+  std::string death_kernel;
+  bool death_tabulated;
+  double death_kernel_tolerance;
+  double death_kernel_max_error;
+  KernelTable death_table;
+
+  std::vector<double> birth_inverse_rcdf_y;
+  double birth_inverse_rcdf_step;
+  int birth_inverse_rcdf_nodes;
+  boost::math::interpolators::cardinal_cubic_b_spline<double> birth_inverse_rcdf_spline;
+
+  static std::string axis_name(int axis) {
+    return std::string(1, "xyz"[axis]);
+  }
+
+  double interaction_at(double squared_distance) const {
+    if (death_tabulated)
+      return death_table(squared_distance);
+    return dd * death_spline(sqrt(squared_distance));
+  }
+
+  //Replaces the death rate of every specimen within death_cutoff_r of point by
+  //update(rate, interaction). The box around the point is searched, and with
+  //periodic boundaries also the parts of it across either end of each axis,
+  //cut short where they would meet the inner part again. Distances are to the
+  //nearest image.
+  template < class F >
+  void update_neighbours(const double * point, F update) {
+    const double r = death_cutoff_r, r2 = death_cutoff_r * death_cutoff_r;
+    auto apply = [&](const double * coords, double rate) {
+      double squared_distance = 0;
+      for (int axis = 0; axis < Dim; axis++) {
+        double delta = point[axis] - coords[axis];
+        if (periodic) {
+          if (delta > area_length[axis] / 2)  delta -= area_length[axis];
+          if (delta < -area_length[axis] / 2) delta += area_length[axis];
+        }
+        squared_distance += delta * delta;
+      }
+      if (squared_distance > r2) return rate;
+      return update(rate, interaction_at(squared_distance));
+    };
+
+    double from[Dim][3], to[Dim][3];
+    int parts[Dim];
+    for (int axis = 0; axis < Dim; axis++) {
+      const double x = point[axis], length = area_length[axis];
+      parts[axis] = 0;
+      if (periodic && x - r < 0) {
+        from[axis][parts[axis]] = std::max(x - r + length, nextafter(x + r, HUGE_VAL));
+        to[axis][parts[axis]++] = length;
+      }
+      from[axis][parts[axis]] = x - r;
+      to[axis][parts[axis]++] = x + r;
+      if (periodic && x + r > length) {
+        from[axis][parts[axis]] = 0;
+        to[axis][parts[axis]++] = std::min(x + r - length, nextafter(x - r, -HUGE_VAL));
+      }
+    }
+    //Every combination of parts along the axes
+    int part[Dim] = {};
+    while (true) {
+      double lo[Dim], hi[Dim];
+      for (int axis = 0; axis < Dim; axis++) {
+        lo[axis] = from[axis][part[axis]];
+        hi[axis] = to[axis][part[axis]];
+      }
+      tree_update(specimens, lo, hi, apply);
+      int axis = 0;
+      while (axis < Dim && ++part[axis] == parts[axis])
+        part[axis++] = 0;
+      if (axis == Dim) break;
+    }
+  }
+
+  //Inserts a specimen and adds its interactions to the death rates of both sides
+  void add_specimen(const double * coords) {
+    double new_death_rate = d;
+    update_neighbours(coords, [&](double rate, double interaction) {
+      new_death_rate += interaction;
+      return rate + interaction;
+    });
+    tree_insert(specimens, coords, new_death_rate);
+    total_population++;
+  }
+
+  std::vector < double > get_all_coords(int axis) {
+    std::vector < double > result;
+    result.reserve(total_population);
+    tree_visit(specimens, [&](const double * coords, double) { result.push_back(coords[axis]); });
+    return result;
+  }
+
+  std::vector < double > get_all_death_rates() {
+    std::vector < double > result;
+    result.reserve(total_population);
+    tree_visit(specimens, [&](const double *, double rate) { result.push_back(rate); });
+    return result;
+  }
+
+  void kill_random() {
+    int dying = specimens.Find(boost::random::uniform_01 < > ()(rng) * specimens.Total());
+    double point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      point[axis] = tree_coord(specimens, dying, axis);
+    specimens.Erase(dying);
+    total_population--;
+
+    update_neighbours(point, [](double rate, double interaction) {
+      return rate - interaction;
+    });
+  }
+
+  template < bool Periodic >
+  void spawn_random() {
+    //Parent is chosen uniformly among all specimens
+    int parent = specimens.Select(boost::random::uniform_int_distribution < > (0, total_population - 1)(rng));
+
+    double at[Dim], point[Dim];
+    for (int axis = 0; axis < Dim; axis++)
+      at[axis] = tree_coord(specimens, parent, axis);
+    draw_offspring < Dim > (birth_inverse_rcdf_spline, rng, at, point);
+
+    for (int axis = 0; axis < Dim; axis++) {
+      //Specimen failed to spawn and died outside area boundaries
+      if (!Boundary < Periodic > ::place(point[axis], area_length[axis])) return;
+    }
+    add_specimen(point);
+  }
+
+  template < bool Periodic >
+  void next_event() {
+    if (total_population == 0)
+      return;
+    event_count++;
+    time += boost::random::exponential_distribution < > (total_population * b + total_death_rate)(rng);
+    //Rolling event according to global birth \ death rate
+    if (boost::random::bernoulli_distribution < > (total_population * b / (total_population * b + total_death_rate))(rng) == 0) {
+      kill_random();
+    } else {
+      spawn_random < Periodic > ();
+    }
+    total_death_rate = specimens.Total();
+  }
+
+  bool realtime_limit_passed() {
+    if (std::chrono::system_clock::now() > init_time + std::chrono::duration<double>(realtime_limit)) {
+      realtime_limit_reached = true;
+      return true;
+    }
+    return false;
+  }
+
+  template < bool Periodic >
+  void run_events_with(int events) {
+    for (int i = 0; i < events; i++) {
+      if (realtime_limit_passed())
+        return;
+      next_event < Periodic > ();
+    }
+  }
+
+  template < bool Periodic >
+  void run_for_with(double time) {
+    double time0 = this->time;
+    while (this->time < time0 + time) {
+      if (realtime_limit_passed())
+        return;
+      next_event < Periodic > ();
+    }
+  }
+
+  void make_event() {
+    if (periodic) next_event < true > ();
+    else          next_event < false > ();
+  }
+
+  void run_events(int events) {
+    if (events <= 0)
+      return;
+    if (periodic) run_events_with < true > (events);
+    else          run_events_with < false > (events);
+  }
+
+  void run_for(double time) {
+    if (time <= 0.0)
+      return;
+    if (periodic) run_for_with < true > (time);
+    else          run_for_with < false > (time);
+  }
+
+  double get_death_spline_value(double at) {
+    return death_spline(at);
+  }
+
+  double get_birth_inverse_rcdf_spline_value(double at) {
+    return birth_inverse_rcdf_spline(at);
+  }
+
+  Tree_nd(Rcpp::List params): specimens(), total_population(), realtime_limit_reached(false),
+  total_death_rate(), time(), event_count(), death_spline(), birth_inverse_rcdf_spline() {
+
+    //Parse parameters, those of the grid are not needed
+
+    for (int axis = 0; axis < Dim; axis++) {
+      area_length[axis] = Rcpp::as < double > (params["area_length_" + axis_name(axis)]);
+      initial_population[axis] = Rcpp::as < std::vector < double >> (params["initial_population_" + axis_name(axis)]);
+    }
+
+    b = Rcpp::as < double > (params["b"]);
+    d = Rcpp::as < double > (params["d"]);
+    dd = Rcpp::as < double > (params["dd"]);
+
+    seed = Rcpp::as < int > (params["seed"]);
+    rng = boost::random::lagged_fibonacci2281(uint32_t(seed));
+
+    death_y = Rcpp::as < std::vector < double >> (params["death_y"]);
+    death_cutoff_r = Rcpp::as < double > (params["death_r"]);
+    death_spline_nodes = death_y.size();
+    death_step = death_cutoff_r / (death_spline_nodes - 1);
+
+    birth_inverse_rcdf_y = Rcpp::as < std::vector < double >> (params["birth_ircdf_y"]);
+    birth_inverse_rcdf_nodes = birth_inverse_rcdf_y.size();
+    birth_inverse_rcdf_step = 1.0 / (birth_inverse_rcdf_nodes - 1);
+
+    periodic = Rcpp::as < bool > (params["periodic"]);
+
+    tree_leaf_size = 16;
+    if (params.containsElementNamed("tree_leaf_size"))
+      tree_leaf_size = Rcpp::as < int > (params["tree_leaf_size"]);
+    if (tree_leaf_size < 2)
+      Rcpp::stop("tree_leaf_size must be at least 2");
+    for (int axis = 0; axis < Dim; axis++) {
+      cell_count[axis] = 1;
+      if (params.containsElementNamed(("cell_count_" + axis_name(axis)).c_str()))
+        cell_count[axis] = Rcpp::as < int > (params["cell_count_" + axis_name(axis)]);
+    }
+    specimens = Index_builder < Index > ::make(*this);
+
+    init_time = std::chrono::system_clock::now();
+    realtime_limit = Rcpp::as<double>(params["realtime_limit"]);
+
+    using boost::math::interpolators::cardinal_cubic_b_spline;
+    //Build death spline, ensure 0 derivative at 0 (symmetric) and endpoint (expected no death interaction further)
+    death_spline = cardinal_cubic_b_spline < double > (death_y.begin(), death_y.end(), 0, death_step, 0, 0);
+
+    death_kernel = "spline";
+    if (params.containsElementNamed("death_kernel"))
+      death_kernel = Rcpp::as < std::string > (params["death_kernel"]);
+    if (death_kernel != "spline" && death_kernel != "table")
+      Rcpp::stop("Unknown death kernel: " + death_kernel);
+    death_tabulated = death_kernel == "table";
+
+    death_kernel_tolerance = 1e-6;
+    if (params.containsElementNamed("death_kernel_tolerance"))
+      death_kernel_tolerance = Rcpp::as < double > (params["death_kernel_tolerance"]);
+    death_kernel_max_error = 0;
+    if (death_tabulated) {
+      if (!(death_kernel_tolerance > 0))
+        Rcpp::stop("death_kernel_tolerance must be positive");
+      if (!death_table.Build([this](double r) { return death_spline(r); }, death_cutoff_r, dd, death_kernel_tolerance))
+        Rcpp::stop("Death kernel table can not reach tolerance " + std::to_string(death_kernel_tolerance));
+      death_kernel_max_error = death_table.MaxError();
+    }
+
+    //Build birth inverse rcdf spline, endpoint derivatives not specified
+    birth_inverse_rcdf_spline = cardinal_cubic_b_spline<double>(birth_inverse_rcdf_y.begin(), birth_inverse_rcdf_y.end(), 0, birth_inverse_rcdf_step);
+
+    //Spawn speciments, each adding its interactions with those before it
+    for (int sp_index = 0; sp_index < static_cast < int > (initial_population[0].size()); sp_index++) {
+      double coords[Dim];
+      bool inside = true;
+      for (int axis = 0; axis < Dim; axis++) {
+        coords[axis] = initial_population[axis][sp_index];
+        if (coords[axis] < 0 || coords[axis] > area_length[axis]) inside = false;
+      }
+      if (!inside) continue;
+      add_specimen(coords);
+    }
+    total_death_rate = specimens.Total();
+  }
+};
+
+//Per-axis fields and methods for the Rcpp modules, which name them by axis
+
+template < int Dim, int Axis, class Index = typename Tree_index < Dim > ::type >
+double tree_area_length_of(Tree_nd < Dim, Index > * tree) {
+  return tree->area_length[Axis];
+}
+
+template < int Dim, int Axis, class Index = typename Tree_index < Dim > ::type >
+std::vector < double > tree_initial_population_of(Tree_nd < Dim, Index > * tree) {
+  return tree->initial_population[Axis];
+}
+
+template < int Dim, int Axis, class Index = typename Tree_index < Dim > ::type >
+std::vector < double > tree_all_coords_of(Tree_nd < Dim, Index > * tree) {
+  return tree->get_all_coords(Axis);
+}
+
+template < int Dim, int Axis >
+int sparse_cell_count_of(Tree_nd < Dim, SparseGrid < Dim > > * sim) {
+  return sim->cell_count[Axis];
+}
+
+//Cells holding at least one specimen, the only ones in memory
+template < int Dim >
+int sparse_occupied_cell_count_of(Tree_nd < Dim, SparseGrid < Dim > > * sim) {
+  return sim->specimens.CellCount();
+}
+
+#endif
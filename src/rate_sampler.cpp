@@ -0,0 +1,60 @@
+#include <boost/random/uniform_01.hpp>
+
+#include "rate_sampler.h"
+
+RateSampler::RateSampler()
+  : UseRejection(false)
+{ }
+
+RateSampler::RateSampler(const std::string& kind)
+  : UseRejection(kind == "composition_rejection")
+{
+  assert(IsKnownKind(kind));
+}
+
+bool RateSampler::IsKnownKind(const std::string& kind) {
+  return kind == "sum_tree" || kind == "composition_rejection";
+}
+
+void RateSampler::Resize(int size) {
+  if (UseRejection) {
+    Bins.Resize(size);
+  } else {
+    Tree.Resize(size);
+  }
+}
+
+void RateSampler::Build(const VEC<double>& weights) {
+  if (UseRejection) {
+    Bins.Build(weights);
+  } else {
+    Tree.Build(weights);
+  }
+}
+
+void RateSampler::Set(int i, double weight) {
+  if (UseRejection) {
+    Bins.Set(i, weight);
+  } else {
+    Tree.Set(i, weight);
+  }
+}
+
+double RateSampler::Get(int i) const {
+  return UseRejection ? Bins.Get(i) : Tree.Get(i);
+}
+
+double RateSampler::Total() const {
+  return UseRejection ? Bins.Total() : Tree.Total();
+}
+
+int RateSampler::Count() const {
+  return UseRejection ? Bins.Count() : Tree.Count();
+}
+
+int RateSampler::Sample(boost::random::lagged_fibonacci2281& rng) const {
+  if (UseRejection) {
+    return Bins.Sample(rng);
+  }
+  return Tree.Find(boost::random::uniform_01<>()(rng) * Tree.Total());
+}
@@ -0,0 +1,39 @@
+#ifndef RATE_SAMPLER
+#define RATE_SAMPLER
+
+#include <string>
+
+#include <boost/random/lagged_fibonacci.hpp>
+
+#include "defines.h"
+#include "sum_tree.h"
+#include "composition_rejection.h"
+
+// Weighted choice of a cell by its death rate. The backend is picked per
+// simulator with the "sampler" parameter:
+//   "sum_tree"              O(log cells) per update and per draw (default)
+//   "composition_rejection" O(1) expected per draw, for very large grids
+class RateSampler {
+  bool UseRejection;
+  SumTree Tree;
+  CompositionRejection Bins;
+
+public:
+  RateSampler();
+  explicit RateSampler(const std::string& kind);
+  
+  static bool IsKnownKind(const std::string& kind);
+  
+  void Resize(int size);
+  void Build(const VEC<double>& weights);
+  
+  void Set(int i, double weight);
+  double Get(int i) const;
+  
+  double Total() const;
+  int Count() const;
+  
+  int Sample(boost::random::lagged_fibonacci2281& rng) const;
+};
+
+#endif
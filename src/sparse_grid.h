@@ -0,0 +1,299 @@
+#ifndef SPARSE_GRID
+#define SPARSE_GRID
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "defines.h"
+#include "cell_map.h"
+#include "sum_tree.h"
+
+// Grid of cells over a box where only cells holding points exist. Occupied
+// cells are numbered densely and found from their coordinates through a
+// CellMap, and rate and count trees run over occupied cells only, so memory
+// and sampling follow the population however many cells the box has.
+// A cell is dropped as soon as its last point goes. Handles stay valid
+// until their point is erased and are reused afterwards.
+template <int Dim>
+class SparseGrid {
+  static const int Nil = -1;
+
+  struct Cell {
+    uint64_t Key;
+    VEC<double> Coords[Dim];
+    VEC<int> Handles;
+    SumTree Rates;
+  };
+
+  struct Ref {
+    int Cell;
+    int Slot;
+  };
+
+  double Lengths[Dim];
+  int Counts[Dim];
+  CellMap Index;
+  VEC<Cell> Cells;
+  SumTree CellRates;
+  SumTree CellCounts;
+  VEC<Ref> Refs;
+  VEC<int> FreeHandles;
+
+  int IndexOf(double coord, int axis) const {
+    int index = static_cast<int>(std::floor(coord * Counts[axis] / Lengths[axis]));
+    return std::min(std::max(index, 0), Counts[axis] - 1);
+  }
+
+  static uint64_t Pack(const int* index) {
+    uint64_t key = 0;
+    for (int axis = Dim - 1; axis >= 0; --axis) {
+      key = key << BitsPerAxis | static_cast<uint64_t>(index[axis]);
+    }
+    return key;
+  }
+
+  void RefreshCell(int cell) {
+    CellRates.Set(cell, Cells[cell].Rates.Total());
+    CellCounts.Set(cell, Cells[cell].Handles.size());
+  }
+
+  void RemoveCell(int cell);
+
+  template <class F>
+  void UpdateCell(int cell, const double* lo, const double* hi, F& update) {
+    Cell& members = Cells[cell];
+    int first = Nil, last = Nil;
+    for (int k = 0; k < static_cast<int>(members.Handles.size()); ++k) {
+      double coords[Dim];
+      bool inside = true;
+      for (int axis = 0; axis < Dim; ++axis) {
+        coords[axis] = members.Coords[axis][k];
+        inside = inside && lo[axis] <= coords[axis] && coords[axis] <= hi[axis];
+      }
+      if (!inside) {
+        continue;
+      }
+      members.Rates.SetLeaf(k, update(static_cast<const double*>(coords), members.Rates.Get(k)));
+      if (first == Nil) {
+        first = k;
+      }
+      last = k;
+    }
+    if (first != Nil) {
+      members.Rates.SumLeaves(first, last);
+      CellRates.Set(cell, members.Rates.Total());
+    }
+  }
+
+public:
+  // Cell coordinates are packed into 63 bits of the key
+  static const int BitsPerAxis = 63 / Dim;
+
+  explicit SparseGrid(const double* lengths = nullptr, const int* counts = nullptr);
+
+  // Returns the handle of the new point, which is expected inside the box
+  int Insert(const double* coords, double rate);
+  void Erase(int handle);
+
+  double Coord(int handle, int axis) const;
+  double Rate(int handle) const;
+
+  // Replaces the rate of every point in the box [lo, hi] by
+  // update(coords, rate). Cells meeting the box are looked up one by one,
+  // or when the box spans more cells than are occupied, occupied cells are
+  // scanned instead, so cells much smaller than the box cost no more than
+  // the population.
+  template <class F>
+  void Update(const double* lo, const double* hi, F update) {
+    int from[Dim], to[Dim], index[Dim];
+    double spanned = 1;
+    for (int axis = 0; axis < Dim; ++axis) {
+      if (hi[axis] < 0 || lo[axis] > Lengths[axis]) {
+        return;
+      }
+      from[axis] = IndexOf(lo[axis], axis);
+      to[axis] = IndexOf(hi[axis], axis);
+      index[axis] = from[axis];
+      spanned *= to[axis] - from[axis] + 1;
+    }
+    if (spanned > Cells.size()) {
+      for (int cell = 0; cell < static_cast<int>(Cells.size()); ++cell) {
+        UpdateCell(cell, lo, hi, update);
+      }
+      return;
+    }
+    while (true) {
+      int cell = Index.Find(Pack(index));
+      if (cell != Nil) {
+        UpdateCell(cell, lo, hi, update);
+      }
+      int axis = 0;
+      while (axis < Dim && index[axis] == to[axis]) {
+        index[axis] = from[axis];
+        axis++;
+      }
+      if (axis == Dim) {
+        break;
+      }
+      index[axis]++;
+    }
+  }
+
+  // Calls visit(coords, rate) for every point, cell by cell
+  template <class F>
+  void Visit(F visit) const {
+    for (const Cell& members : Cells) {
+      for (int k = 0; k < static_cast<int>(members.Handles.size()); ++k) {
+        double coords[Dim];
+        for (int axis = 0; axis < Dim; ++axis) {
+          coords[axis] = members.Coords[axis][k];
+        }
+        visit(static_cast<const double*>(coords), members.Rates.Get(k));
+      }
+    }
+  }
+
+  double Total() const;
+  int Count() const;
+  // Cells that exist, those holding at least one point
+  int CellCount() const;
+
+  // Handle of the point whose cumulative rate interval contains u, u is
+  // expected in [0, Total())
+  int Find(double u) const;
+  // Handle of the point with rank points before it, cell by cell
+  int Select(int rank) const;
+};
+
+template <int Dim>
+SparseGrid<Dim>::SparseGrid(const double* lengths, const int* counts) {
+  for (int axis = 0; axis < Dim; ++axis) {
+    Lengths[axis] = lengths ? lengths[axis] : 1;
+    Counts[axis] = counts ? counts[axis] : 1;
+    assert(Counts[axis] >= 1 && static_cast<uint64_t>(Counts[axis]) <= static_cast<uint64_t>(1) << BitsPerAxis);
+  }
+}
+
+template <int Dim>
+int SparseGrid<Dim>::Insert(const double* coords, double rate) {
+  int index[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    index[axis] = IndexOf(coords[axis], axis);
+  }
+  uint64_t key = Pack(index);
+  int cell = Index.Find(key);
+  if (cell == Nil) {
+    cell = Cells.size();
+    Cells.emplace_back();
+    Cells[cell].Key = key;
+    Index.Insert(key, cell);
+    CellRates.Push(0);
+    CellCounts.Push(0);
+  }
+
+  int handle;
+  if (FreeHandles.empty()) {
+    handle = Refs.size();
+    Refs.emplace_back();
+  } else {
+    handle = FreeHandles.back();
+    FreeHandles.pop_back();
+  }
+  Cell& members = Cells[cell];
+  Refs[handle].Cell = cell;
+  Refs[handle].Slot = members.Handles.size();
+  for (int axis = 0; axis < Dim; ++axis) {
+    members.Coords[axis].push_back(coords[axis]);
+  }
+  members.Handles.push_back(handle);
+  members.Rates.Push(rate);
+  RefreshCell(cell);
+  return handle;
+}
+
+template <int Dim>
+void SparseGrid<Dim>::Erase(int handle) {
+  assert(handle >= 0 && handle < static_cast<int>(Refs.size()));
+  int cell = Refs[handle].Cell, slot = Refs[handle].Slot;
+  Cell& members = Cells[cell];
+  int last = members.Handles.size() - 1;
+  for (int axis = 0; axis < Dim; ++axis) {
+    members.Coords[axis][slot] = members.Coords[axis][last];
+    members.Coords[axis].pop_back();
+  }
+  members.Handles[slot] = members.Handles[last];
+  members.Handles.pop_back();
+  if (slot != last) {
+    Refs[members.Handles[slot]].Slot = slot;
+  }
+  members.Rates.SwapWithLast(slot);
+  members.Rates.Pop();
+  FreeHandles.push_back(handle);
+
+  if (members.Handles.empty()) {
+    RemoveCell(cell);
+  } else {
+    RefreshCell(cell);
+  }
+}
+
+// The last cell takes the number of the removed one
+template <int Dim>
+void SparseGrid<Dim>::RemoveCell(int cell) {
+  Index.Erase(Cells[cell].Key);
+  int last = Cells.size() - 1;
+  if (cell != last) {
+    std::swap(Cells[cell], Cells[last]);
+    Index.Set(Cells[cell].Key, cell);
+    for (int handle : Cells[cell].Handles) {
+      Refs[handle].Cell = cell;
+    }
+  }
+  Cells.pop_back();
+  CellRates.SwapWithLast(cell);
+  CellRates.Pop();
+  CellCounts.SwapWithLast(cell);
+  CellCounts.Pop();
+}
+
+template <int Dim>
+double SparseGrid<Dim>::Coord(int handle, int axis) const {
+  return Cells[Refs[handle].Cell].Coords[axis][Refs[handle].Slot];
+}
+
+template <int Dim>
+double SparseGrid<Dim>::Rate(int handle) const {
+  return Cells[Refs[handle].Cell].Rates.Get(Refs[handle].Slot);
+}
+
+template <int Dim>
+double SparseGrid<Dim>::Total() const {
+  return CellRates.Total();
+}
+
+template <int Dim>
+int SparseGrid<Dim>::Count() const {
+  return static_cast<int>(CellCounts.Total() + 0.5);
+}
+
+template <int Dim>
+int SparseGrid<Dim>::CellCount() const {
+  return Cells.size();
+}
+
+template <int Dim>
+int SparseGrid<Dim>::Find(double u) const {
+  double rest;
+  const Cell& members = Cells[CellRates.Find(u, rest)];
+  return members.Handles[members.Rates.Find(rest)];
+}
+
+template <int Dim>
+int SparseGrid<Dim>::Select(int rank) const {
+  double rest;
+  const Cell& members = Cells[CellCounts.Find(rank + 0.5, rest)];
+  return members.Handles[static_cast<int>(rest)];
+}
+
+#endif
@@ -0,0 +1,414 @@
+#ifndef SPATIAL_TREE
+#define SPATIAL_TREE
+
+#include <cstddef>
+
+#include "defines.h"
+
+// Adaptive 2^Dim-ary tree of points in a box, a quadtree in 2d and an
+// octree in 3d, each point with a non-negative rate. A leaf holds up to
+// LeafSize points and splits into equal halves along every axis when it
+// gets more; a subtree that falls to LeafSize / 2 points is collapsed back
+// into a leaf. Every node holds the count and rate sum of its subtree, so a
+// rate weighted or uniform draw costs O(depth), and dense clusters get deep
+// small leaves while empty space costs nothing. Handles stay valid until
+// their point is erased and are reused afterwards.
+template <int Dim>
+class SpatialTree {
+  static const int Nil = -1;
+  static const int Children = 1 << Dim;
+  // Points closer than the area over 2^MaxDepth share a leaf of any size
+  static const int MaxDepth = 30;
+
+  struct Node {
+    double Lo[Dim];
+    double Hi[Dim];
+    double Sum;
+    int Count;
+    int Parent;
+    // Children are consecutive, Nil for a leaf
+    int FirstChild;
+    int Depth;
+  };
+
+  struct Point {
+    double Coords[Dim];
+    double Rate;
+    int Leaf;
+    int Slot;
+  };
+
+  int LeafSize;
+  VEC<Node> Nodes;
+  // Handles of the points of each leaf, empty for inner nodes
+  MAT<int> Members;
+  VEC<int> FreeBlocks;
+  VEC<Point> Points;
+  VEC<int> FreePoints;
+
+  int ChildOf(int node, const double* coords) const;
+  void Refresh(int node);
+  void RefreshUp(int node);
+  int AllocateChildren(int parent);
+  void Place(int leaf, int handle);
+  void Split(int leaf);
+  void Gather(int node, VEC<int>& handles);
+  void Collapse(int node);
+
+  template <class F>
+  void UpdateAt(int node, const double* lo, const double* hi, F& update) {
+    const Node& box = Nodes[node];
+    for (int axis = 0; axis < Dim; ++axis) {
+      if (box.Hi[axis] < lo[axis] || box.Lo[axis] > hi[axis]) {
+        return;
+      }
+    }
+    if (box.FirstChild == Nil) {
+      for (int handle : Members[node]) {
+        Point& point = Points[handle];
+        bool inside = true;
+        for (int axis = 0; axis < Dim; ++axis) {
+          inside = inside && lo[axis] <= point.Coords[axis] && point.Coords[axis] <= hi[axis];
+        }
+        if (inside) {
+          point.Rate = update(static_cast<const double*>(point.Coords), point.Rate);
+          if (point.Rate < 0) {
+            point.Rate = 0;
+          }
+        }
+      }
+    } else {
+      for (int child = box.FirstChild; child < box.FirstChild + Children; ++child) {
+        UpdateAt(child, lo, hi, update);
+      }
+    }
+    Refresh(node);
+  }
+
+public:
+  explicit SpatialTree(const double* lengths = nullptr, int leafSize = 16);
+
+  // Returns the handle of the new point, which is expected inside the box
+  int Insert(const double* coords, double rate);
+  void Erase(int handle);
+
+  double Coord(int handle, int axis) const;
+  double Rate(int handle) const;
+
+  // Replaces the rate of every point in the box [lo, hi] by
+  // update(coords, rate). Only nodes that meet the box are visited and only
+  // their sums are restored on the way back.
+  template <class F>
+  void Update(const double* lo, const double* hi, F update) {
+    UpdateAt(0, lo, hi, update);
+  }
+
+  // Calls visit(coords, rate) for every point, leaf by leaf
+  template <class F>
+  void Visit(F visit) const {
+    for (std::size_t node = 0; node < Nodes.size(); ++node) {
+      for (int handle : Members[node]) {
+        visit(static_cast<const double*>(Points[handle].Coords), Points[handle].Rate);
+      }
+    }
+  }
+
+  double Total() const;
+  int Count() const;
+  int NodeCount() const;
+  int LeafCount() const;
+  int Height() const;
+
+  // Handle of the point whose cumulative rate interval contains u, u is
+  // expected in [0, Total()). Zero-rate points are not returned while any
+  // rate is positive.
+  int Find(double u) const;
+  // Handle of the point with rank points before it in tree order
+  int Select(int rank) const;
+};
+
+template <int Dim>
+SpatialTree<Dim>::SpatialTree(const double* lengths, int leafSize)
+  : LeafSize(leafSize)
+  , Nodes(1)
+  , Members(1)
+{
+  assert(leafSize >= 2);
+  Node& root = Nodes[0];
+  for (int axis = 0; axis < Dim; ++axis) {
+    root.Lo[axis] = 0;
+    root.Hi[axis] = lengths ? lengths[axis] : 1;
+  }
+  root.Sum = 0;
+  root.Count = 0;
+  root.Parent = Nil;
+  root.FirstChild = Nil;
+  root.Depth = 0;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::ChildOf(int node, const double* coords) const {
+  const Node& box = Nodes[node];
+  int child = 0;
+  for (int axis = 0; axis < Dim; ++axis) {
+    if (coords[axis] >= 0.5 * (box.Lo[axis] + box.Hi[axis])) {
+      child |= 1 << axis;
+    }
+  }
+  return box.FirstChild + child;
+}
+
+// Sums are taken afresh from the leaves or children, so they never drift
+template <int Dim>
+void SpatialTree<Dim>::Refresh(int node) {
+  Node& box = Nodes[node];
+  box.Sum = 0;
+  if (box.FirstChild == Nil) {
+    for (int handle : Members[node]) {
+      box.Sum += Points[handle].Rate;
+    }
+    box.Count = Members[node].size();
+  } else {
+    box.Count = 0;
+    for (int child = box.FirstChild; child < box.FirstChild + Children; ++child) {
+      box.Sum += Nodes[child].Sum;
+      box.Count += Nodes[child].Count;
+    }
+  }
+}
+
+template <int Dim>
+void SpatialTree<Dim>::RefreshUp(int node) {
+  for (; node != Nil; node = Nodes[node].Parent) {
+    Refresh(node);
+  }
+}
+
+template <int Dim>
+int SpatialTree<Dim>::AllocateChildren(int parent) {
+  int first;
+  if (FreeBlocks.empty()) {
+    first = Nodes.size();
+    Nodes.resize(first + Children);
+    Members.resize(first + Children);
+  } else {
+    first = FreeBlocks.back();
+    FreeBlocks.pop_back();
+  }
+  const Node box = Nodes[parent];
+  for (int child = 0; child < Children; ++child) {
+    Node& node = Nodes[first + child];
+    for (int axis = 0; axis < Dim; ++axis) {
+      double middle = 0.5 * (box.Lo[axis] + box.Hi[axis]);
+      node.Lo[axis] = child >> axis & 1 ? middle : box.Lo[axis];
+      node.Hi[axis] = child >> axis & 1 ? box.Hi[axis] : middle;
+    }
+    node.Sum = 0;
+    node.Count = 0;
+    node.Parent = parent;
+    node.FirstChild = Nil;
+    node.Depth = box.Depth + 1;
+    Members[first + child].clear();
+  }
+  return first;
+}
+
+template <int Dim>
+void SpatialTree<Dim>::Place(int leaf, int handle) {
+  Points[handle].Leaf = leaf;
+  Points[handle].Slot = Members[leaf].size();
+  Members[leaf].push_back(handle);
+}
+
+template <int Dim>
+void SpatialTree<Dim>::Split(int leaf) {
+  int first = AllocateChildren(leaf);
+  Nodes[leaf].FirstChild = first;
+  VEC<int> handles;
+  handles.swap(Members[leaf]);
+  for (int handle : handles) {
+    Place(ChildOf(leaf, Points[handle].Coords), handle);
+  }
+  for (int child = first; child < first + Children; ++child) {
+    Refresh(child);
+  }
+  // All points may have gone to one child
+  for (int child = first; child < first + Children; ++child) {
+    if (Nodes[child].Count > LeafSize && Nodes[child].Depth < MaxDepth) {
+      Split(child);
+    }
+  }
+  Refresh(leaf);
+}
+
+template <int Dim>
+void SpatialTree<Dim>::Gather(int node, VEC<int>& handles) {
+  if (Nodes[node].FirstChild == Nil) {
+    handles.insert(handles.end(), Members[node].begin(), Members[node].end());
+    Members[node].clear();
+    return;
+  }
+  int first = Nodes[node].FirstChild;
+  for (int child = first; child < first + Children; ++child) {
+    Gather(child, handles);
+  }
+  Nodes[node].FirstChild = Nil;
+  FreeBlocks.push_back(first);
+}
+
+template <int Dim>
+void SpatialTree<Dim>::Collapse(int node) {
+  VEC<int> handles;
+  Gather(node, handles);
+  for (int handle : handles) {
+    Place(node, handle);
+  }
+  Refresh(node);
+}
+
+template <int Dim>
+int SpatialTree<Dim>::Insert(const double* coords, double rate) {
+  int handle;
+  if (FreePoints.empty()) {
+    handle = Points.size();
+    Points.emplace_back();
+  } else {
+    handle = FreePoints.back();
+    FreePoints.pop_back();
+  }
+  Point& point = Points[handle];
+  for (int axis = 0; axis < Dim; ++axis) {
+    point.Coords[axis] = coords[axis];
+  }
+  point.Rate = rate < 0 ? 0 : rate;
+
+  int node = 0;
+  while (Nodes[node].FirstChild != Nil) {
+    node = ChildOf(node, coords);
+  }
+  Place(node, handle);
+  if (static_cast<int>(Members[node].size()) > LeafSize && Nodes[node].Depth < MaxDepth) {
+    Split(node);
+  }
+  RefreshUp(node);
+  return handle;
+}
+
+template <int Dim>
+void SpatialTree<Dim>::Erase(int handle) {
+  assert(handle >= 0 && handle < static_cast<int>(Points.size()));
+  int leaf = Points[handle].Leaf;
+  VEC<int>& members = Members[leaf];
+  int slot = Points[handle].Slot;
+  members[slot] = members.back();
+  Points[members[slot]].Slot = slot;
+  members.pop_back();
+  FreePoints.push_back(handle);
+  RefreshUp(leaf);
+
+  // The highest ancestor left with few enough points becomes a leaf
+  int top = Nil;
+  for (int node = Nodes[leaf].Parent; node != Nil && Nodes[node].Count <= LeafSize / 2; node = Nodes[node].Parent) {
+    top = node;
+  }
+  if (top != Nil) {
+    Collapse(top);
+  }
+}
+
+template <int Dim>
+double SpatialTree<Dim>::Coord(int handle, int axis) const {
+  return Points[handle].Coords[axis];
+}
+
+template <int Dim>
+double SpatialTree<Dim>::Rate(int handle) const {
+  return Points[handle].Rate;
+}
+
+template <int Dim>
+double SpatialTree<Dim>::Total() const {
+  return Nodes[0].Sum;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::Count() const {
+  return Nodes[0].Count;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::NodeCount() const {
+  return Nodes.size() - FreeBlocks.size() * Children;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::LeafCount() const {
+  return (NodeCount() - 1) / Children * (Children - 1) + 1;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::Height() const {
+  int height = 0;
+  for (std::size_t node = 0; node < Nodes.size(); ++node) {
+    if (!Members[node].empty() && Nodes[node].Depth > height) {
+      height = Nodes[node].Depth;
+    }
+  }
+  return height;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::Find(double u) const {
+  assert(Count() > 0);
+  int node = 0;
+  while (Nodes[node].FirstChild != Nil) {
+    int first = Nodes[node].FirstChild;
+    // Last child with a positive sum, the answer if u runs past the total
+    // through rounding
+    int next = Nil;
+    for (int child = first; child < first + Children; ++child) {
+      if (Nodes[child].Sum <= 0) {
+        continue;
+      }
+      next = child;
+      if (u < Nodes[child].Sum) {
+        break;
+      }
+      u -= Nodes[child].Sum;
+    }
+    if (next == Nil) {
+      // All rates are zero, any point will do
+      return Select(0);
+    }
+    node = next;
+  }
+  int last = Members[node].front();
+  for (int handle : Members[node]) {
+    double rate = Points[handle].Rate;
+    if (rate > 0) {
+      if (u < rate) {
+        return handle;
+      }
+      last = handle;
+      u -= rate;
+    }
+  }
+  return last;
+}
+
+template <int Dim>
+int SpatialTree<Dim>::Select(int rank) const {
+  assert(rank >= 0 && rank < Count());
+  int node = 0;
+  while (Nodes[node].FirstChild != Nil) {
+    int child = Nodes[node].FirstChild;
+    while (rank >= Nodes[child].Count) {
+      rank -= Nodes[child].Count;
+      child++;
+    }
+    node = child;
+  }
+  return Members[node][rank];
+}
+
+#endif
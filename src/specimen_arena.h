@@ -0,0 +1,273 @@
+#ifndef SPECIMEN_ARENA
+#define SPECIMEN_ARENA
+
+#include "defines.h"
+
+// Structure-of-arrays storage for the specimens of a cell grid. Each cell
+// owns a contiguous range of every array and ranges are laid out in cell
+// order, so a sweep over neighbouring cells is a streaming read. A cell that
+// outgrows its range is moved to the free tail of the arrays; once the tail
+// is exhausted all cells are re-packed in order with fresh slack.
+// Pointers returned for a cell stay valid until the next Add().
+template <int Dim>
+class SpecimenArena {
+  VEC<double> _Coords[Dim];
+  VEC<double> _DeathRates;
+  VEC<int> _Species;
+
+  VEC<int> _Begin;
+  VEC<int> _Size;
+  VEC<int> _Capacity;
+
+  int Used;
+  int Live;
+  int Repacks;
+
+  static int Slack(int size) {
+    return size / 4 + 2;
+  }
+
+  int Length() const {
+    return _DeathRates.size();
+  }
+
+  void Grow(int cell);
+  void Move(int cell, int begin, int capacity);
+
+public:
+  SpecimenArena();
+  explicit SpecimenArena(int cellCount);
+
+  int CellCount() const;
+  int CellSize(int cell) const;
+  int Count() const;
+  int RepackCount() const;
+
+  double* Coords(int axis, int cell);
+  const double* Coords(int axis, int cell) const;
+  double* DeathRates(int cell);
+  const double* DeathRates(int cell) const;
+  int* Species(int cell);
+  const int* Species(int cell) const;
+
+  // Appends a specimen to the cell and returns its slot
+  int Add(int cell, const double* coords, double deathRate, int species = 0);
+
+  // Last specimen of the cell takes the place of the removed one
+  void Remove(int cell, int slot);
+
+  // Puts a specimen at the slot and moves the ones after it up by one,
+  // so the order of the cell is kept
+  void Insert(int cell, int slot, const double* coords, double deathRate, int species = 0);
+
+  // Removes the specimen and moves the ones after it down by one
+  void Erase(int cell, int slot);
+
+  // Lays cells out contiguously in index order, each with some slack
+  void Repack();
+};
+
+template <int Dim>
+SpecimenArena<Dim>::SpecimenArena()
+  : SpecimenArena(0)
+{ }
+
+template <int Dim>
+SpecimenArena<Dim>::SpecimenArena(int cellCount)
+  : _Begin(cellCount, 0)
+  , _Size(cellCount, 0)
+  , _Capacity(cellCount, 0)
+  , Used(0)
+  , Live(0)
+  , Repacks(0)
+{
+  Repack();
+  Repacks = 0;
+}
+
+template <int Dim>
+int SpecimenArena<Dim>::CellCount() const {
+  return _Size.size();
+}
+
+template <int Dim>
+int SpecimenArena<Dim>::CellSize(int cell) const {
+  return _Size[cell];
+}
+
+template <int Dim>
+int SpecimenArena<Dim>::Count() const {
+  return Live;
+}
+
+template <int Dim>
+int SpecimenArena<Dim>::RepackCount() const {
+  return Repacks;
+}
+
+template <int Dim>
+double* SpecimenArena<Dim>::Coords(int axis, int cell) {
+  return _Coords[axis].data() + _Begin[cell];
+}
+
+template <int Dim>
+const double* SpecimenArena<Dim>::Coords(int axis, int cell) const {
+  return _Coords[axis].data() + _Begin[cell];
+}
+
+template <int Dim>
+double* SpecimenArena<Dim>::DeathRates(int cell) {
+  return _DeathRates.data() + _Begin[cell];
+}
+
+template <int Dim>
+const double* SpecimenArena<Dim>::DeathRates(int cell) const {
+  return _DeathRates.data() + _Begin[cell];
+}
+
+template <int Dim>
+int* SpecimenArena<Dim>::Species(int cell) {
+  return _Species.data() + _Begin[cell];
+}
+
+template <int Dim>
+const int* SpecimenArena<Dim>::Species(int cell) const {
+  return _Species.data() + _Begin[cell];
+}
+
+template <int Dim>
+void SpecimenArena<Dim>::Move(int cell, int begin, int capacity) {
+  for (int k = 0; k < _Size[cell]; ++k) {
+    for (int axis = 0; axis < Dim; ++axis) {
+      _Coords[axis][begin + k] = _Coords[axis][_Begin[cell] + k];
+    }
+    _DeathRates[begin + k] = _DeathRates[_Begin[cell] + k];
+    _Species[begin + k] = _Species[_Begin[cell] + k];
+  }
+  _Begin[cell] = begin;
+  _Capacity[cell] = capacity;
+}
+
+template <int Dim>
+void SpecimenArena<Dim>::Grow(int cell) {
+  int capacity = 2 * _Capacity[cell] + 2;
+
+  // The last range can simply be extended into the tail
+  if (_Begin[cell] + _Capacity[cell] == Used && _Begin[cell] + capacity <= Length()) {
+    _Capacity[cell] = capacity;
+    Used = _Begin[cell] + capacity;
+    return;
+  }
+  if (Used + capacity > Length()) {
+    // Re-packing leaves every cell at least Slack(size) free slots
+    Repack();
+    return;
+  }
+  Move(cell, Used, capacity);
+  Used += capacity;
+}
+
+template <int Dim>
+int SpecimenArena<Dim>::Add(int cell, const double* coords, double deathRate, int species) {
+  if (_Size[cell] == _Capacity[cell]) {
+    Grow(cell);
+  }
+  int i = _Begin[cell] + _Size[cell];
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Coords[axis][i] = coords[axis];
+  }
+  _DeathRates[i] = deathRate;
+  _Species[i] = species;
+  ++Live;
+  return _Size[cell]++;
+}
+
+template <int Dim>
+void SpecimenArena<Dim>::Remove(int cell, int slot) {
+  int i = _Begin[cell] + slot;
+  int last = _Begin[cell] + _Size[cell] - 1;
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Coords[axis][i] = _Coords[axis][last];
+  }
+  _DeathRates[i] = _DeathRates[last];
+  _Species[i] = _Species[last];
+  --_Size[cell];
+  --Live;
+}
+
+template <int Dim>
+void SpecimenArena<Dim>::Insert(int cell, int slot, const double* coords, double deathRate, int species) {
+  if (_Size[cell] == _Capacity[cell]) {
+    Grow(cell);
+  }
+  int i = _Begin[cell] + slot;
+  for (int k = _Begin[cell] + _Size[cell]; k > i; --k) {
+    for (int axis = 0; axis < Dim; ++axis) {
+      _Coords[axis][k] = _Coords[axis][k - 1];
+    }
+    _DeathRates[k] = _DeathRates[k - 1];
+    _Species[k] = _Species[k - 1];
+  }
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Coords[axis][i] = coords[axis];
+  }
+  _DeathRates[i] = deathRate;
+  _Species[i] = species;
+  ++_Size[cell];
+  ++Live;
+}
+
+template <int Dim>
+void SpecimenArena<Dim>::Erase(int cell, int slot) {
+  int last = _Begin[cell] + _Size[cell] - 1;
+  for (int k = _Begin[cell] + slot; k < last; ++k) {
+    for (int axis = 0; axis < Dim; ++axis) {
+      _Coords[axis][k] = _Coords[axis][k + 1];
+    }
+    _DeathRates[k] = _DeathRates[k + 1];
+    _Species[k] = _Species[k + 1];
+  }
+  --_Size[cell];
+  --Live;
+}
+
+template <int Dim>
+void SpecimenArena<Dim>::Repack() {
+  int packed = 0;
+  for (int cell = 0; cell < CellCount(); ++cell) {
+    packed += _Size[cell] + Slack(_Size[cell]);
+  }
+  // Free tail of the same size absorbs relocations until the next re-pack
+  int length = 2 * packed;
+
+  VEC<double> coords[Dim];
+  for (int axis = 0; axis < Dim; ++axis) {
+    coords[axis].resize(length);
+  }
+  VEC<double> deathRates(length);
+  VEC<int> species(length);
+
+  int begin = 0;
+  for (int cell = 0; cell < CellCount(); ++cell) {
+    for (int k = 0; k < _Size[cell]; ++k) {
+      for (int axis = 0; axis < Dim; ++axis) {
+        coords[axis][begin + k] = _Coords[axis][_Begin[cell] + k];
+      }
+      deathRates[begin + k] = _DeathRates[_Begin[cell] + k];
+      species[begin + k] = _Species[_Begin[cell] + k];
+    }
+    _Begin[cell] = begin;
+    _Capacity[cell] = _Size[cell] + Slack(_Size[cell]);
+    begin += _Capacity[cell];
+  }
+
+  for (int axis = 0; axis < Dim; ++axis) {
+    _Coords[axis].swap(coords[axis]);
+  }
+  _DeathRates.swap(deathRates);
+  _Species.swap(species);
+  Used = begin;
+  ++Repacks;
+}
+
+#endif
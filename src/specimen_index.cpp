@@ -0,0 +1,85 @@
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "specimen_index.h"
+
+SpecimenIndex::SpecimenIndex()
+  : SpecimenIndex(1, 0)
+{ }
+
+SpecimenIndex::SpecimenIndex(int speciesCount, int cellCount)
+  : Handles(speciesCount)
+  , Positions(cellCount)
+{ }
+
+void SpecimenIndex::Add(int cell, int species) {
+  SpecimenHandle handle;
+  handle.Cell = cell;
+  handle.Slot = Positions[cell].size();
+  Positions[cell].push_back(Handles[species].size());
+  Handles[species].push_back(handle);
+}
+
+void SpecimenIndex::Remove(int cell, int slot, int species, int lastSpecies) {
+  VEC<SpecimenHandle> &handles = Handles[species];
+  int position = Positions[cell][slot];
+  
+  SpecimenHandle moved = handles.back();
+  handles[position] = moved;
+  Positions[moved.Cell][moved.Slot] = position;
+  handles.pop_back();
+  
+  int last = Positions[cell].size() - 1;
+  if (slot != last) {
+    int lastPosition = Positions[cell][last];
+    Handles[lastSpecies][lastPosition].Slot = slot;
+    Positions[cell][slot] = lastPosition;
+  }
+  Positions[cell].pop_back();
+}
+
+void SpecimenIndex::Insert(int cell, int slot, int species, const int* cellSpecies) {
+  SpecimenHandle handle;
+  handle.Cell = cell;
+  handle.Slot = slot;
+  VEC<int> &positions = Positions[cell];
+  positions.insert(positions.begin() + slot, Handles[species].size());
+  Handles[species].push_back(handle);
+  
+  for (int later = slot + 1; later < static_cast<int>(positions.size()); ++later) {
+    Handles[cellSpecies[later]][positions[later]].Slot = later;
+  }
+}
+
+void SpecimenIndex::Erase(int cell, int slot, int species, const int* cellSpecies) {
+  VEC<SpecimenHandle> &handles = Handles[species];
+  VEC<int> &positions = Positions[cell];
+  int position = positions[slot];
+  
+  SpecimenHandle moved = handles.back();
+  handles[position] = moved;
+  Positions[moved.Cell][moved.Slot] = position;
+  handles.pop_back();
+  
+  positions.erase(positions.begin() + slot);
+  for (int later = slot; later < static_cast<int>(positions.size()); ++later) {
+    Handles[cellSpecies[later]][positions[later]].Slot = later;
+  }
+}
+
+int SpecimenIndex::Count(int species) const {
+  return Handles[species].size();
+}
+
+const SpecimenHandle& SpecimenIndex::At(int species, int i) const {
+  return Handles[species][i];
+}
+
+SpecimenHandle SpecimenIndex::Sample(
+  boost::random::lagged_fibonacci2281& rng,
+  int species
+) const {
+  const VEC<SpecimenHandle> &handles = Handles[species];
+  return handles[
+    boost::random::uniform_int_distribution<>(0, handles.size() - 1)(rng)
+  ];
+}
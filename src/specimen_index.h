@@ -0,0 +1,43 @@
+#ifndef SPECIMEN_INDEX
+#define SPECIMEN_INDEX
+
+#include <boost/random/lagged_fibonacci.hpp>
+
+#include "defines.h"
+
+struct SpecimenHandle {
+  int Cell;
+  int Slot;
+};
+
+// Dense per-species array of (cell, slot) handles of every live specimen,
+// so a uniformly chosen parent is one integer draw and a lookup.
+// Cells store specimens in vectors with swap-with-last removal, the index
+// has to be told about both ends of that swap through Remove().
+class SpecimenIndex {
+  MAT<SpecimenHandle> Handles;
+  MAT<int> Positions;
+
+public:
+  SpecimenIndex();
+  SpecimenIndex(int speciesCount, int cellCount);
+  
+  // Specimen has been appended to the end of the cell
+  void Add(int cell, int species);
+  
+  // Specimen in slot is about to be replaced by the last one of the cell,
+  // lastSpecies is the species of that last specimen
+  void Remove(int cell, int slot, int species, int lastSpecies);
+
+  // Counterparts of SpecimenArena::Insert and Erase, called after them.
+  // cellSpecies lists the species of the cell's slots as they are now.
+  void Insert(int cell, int slot, int species, const int* cellSpecies);
+  void Erase(int cell, int slot, int species, const int* cellSpecies);
+  
+  int Count(int species) const;
+  const SpecimenHandle& At(int species, int i) const;
+  
+  SpecimenHandle Sample(boost::random::lagged_fibonacci2281& rng, int species) const;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "sum_tree.h"
+
+SumTree::SumTree()
+  : Leaves(0)
+  , Capacity(1)
+  , Nodes(2, 0)
+{ }
+
+SumTree::SumTree(int size)
+  : SumTree()
+{
+  Resize(size);
+}
+
+void SumTree::Resize(int size) {
+  Leaves = size;
+  Capacity = 1;
+  while (Capacity < size) {
+    Capacity *= 2;
+  }
+  Nodes.assign(2 * Capacity, 0);
+}
+
+void SumTree::Build(const VEC<double>& weights) {
+  Resize(weights.size());
+  for (int i = 0; i < Leaves; ++i) {
+    Nodes[Capacity + i] = weights[i] < 0 ? 0 : weights[i];
+  }
+  for (int node = Capacity - 1; node > 0; --node) {
+    Nodes[node] = Nodes[2 * node] + Nodes[2 * node + 1];
+  }
+}
+
+void SumTree::Set(int i, double weight) {
+  assert(i >= 0 && i < Leaves);
+  int node = Capacity + i;
+  Nodes[node] = weight < 0 ? 0 : weight;
+  for (node /= 2; node > 0; node /= 2) {
+    Nodes[node] = Nodes[2 * node] + Nodes[2 * node + 1];
+  }
+}
+
+double SumTree::Get(int i) const {
+  return Nodes[Capacity + i];
+}
+
+void SumTree::Grow() {
+  VEC<double> nodes(4 * Capacity, 0);
+  for (int i = 0; i < Leaves; ++i) {
+    nodes[2 * Capacity + i] = Nodes[Capacity + i];
+  }
+  Capacity *= 2;
+  Nodes.swap(nodes);
+  for (int node = Capacity - 1; node > 0; --node) {
+    Nodes[node] = Nodes[2 * node] + Nodes[2 * node + 1];
+  }
+}
+
+void SumTree::Push(double weight) {
+  if (Leaves == Capacity) {
+    Grow();
+  }
+  ++Leaves;
+  Set(Leaves - 1, weight);
+}
+
+void SumTree::SwapWithLast(int i) {
+  Set(i, Get(Leaves - 1));
+}
+
+void SumTree::Pop() {
+  Set(Leaves - 1, 0);
+  --Leaves;
+}
+
+void SumTree::SetLeaf(int i, double weight) {
+  assert(i >= 0 && i < Leaves);
+  Nodes[Capacity + i] = weight < 0 ? 0 : weight;
+}
+
+// Inner nodes above leaves [first, last] are summed again, level by level
+void SumTree::SumLeaves(int first, int last) {
+  for (int low = (Capacity + first) / 2, high = (Capacity + last) / 2; low > 0; low /= 2, high /= 2) {
+    for (int node = low; node <= high; ++node) {
+      Nodes[node] = Nodes[2 * node] + Nodes[2 * node + 1];
+    }
+  }
+}
+
+void SumTree::Insert(int i, double weight) {
+  assert(i >= 0 && i <= Leaves);
+  if (Leaves == Capacity) {
+    Grow();
+  }
+  for (int leaf = Leaves; leaf > i; --leaf) {
+    Nodes[Capacity + leaf] = Nodes[Capacity + leaf - 1];
+  }
+  Nodes[Capacity + i] = weight < 0 ? 0 : weight;
+  ++Leaves;
+  SumLeaves(i, Leaves - 1);
+}
+
+void SumTree::Erase(int i) {
+  assert(i >= 0 && i < Leaves);
+  for (int leaf = i; leaf < Leaves - 1; ++leaf) {
+    Nodes[Capacity + leaf] = Nodes[Capacity + leaf + 1];
+  }
+  Nodes[Capacity + Leaves - 1] = 0;
+  SumLeaves(i, Leaves - 1);
+  --Leaves;
+}
+
+double SumTree::Total() const {
+  return Nodes[1];
+}
+
+int SumTree::Count() const {
+  return Leaves;
+}
+
+int SumTree::Find(double u) const {
+  double rest;
+  return Find(u, rest);
+}
+
+int SumTree::Find(double u, double& rest) const {
+  int node = 1;
+  while (node < Capacity) {
+    double left = Nodes[2 * node];
+    if (u < left || Nodes[2 * node + 1] <= 0) {
+      node = 2 * node;
+    } else {
+      u -= left;
+      node = 2 * node + 1;
+    }
+  }
+  rest = u;
+  return node - Capacity;
+}
@@ -0,0 +1,52 @@
+#ifndef SUM_TREE
+#define SUM_TREE
+
+#include "defines.h"
+
+// Complete binary tree over non-negative weights. Every inner node holds the
+// exact sum of its two children, so point updates, the total and a weighted
+// draw are O(log n) and never allocate once the tree has been sized.
+class SumTree {
+  int Leaves;
+  int Capacity;
+  VEC<double> Nodes;
+
+  void Grow();
+
+public:
+  SumTree();
+  explicit SumTree(int size);
+
+  void Resize(int size);
+  void Build(const VEC<double>& weights);
+
+  void Set(int i, double weight);
+  double Get(int i) const;
+
+  // Set of several leaves at once: SetLeaf each of them, then SumLeaves over
+  // the range they span, O(range + log n) rather than O(log n) per leaf
+  void SetLeaf(int i, double weight);
+  void SumLeaves(int first, int last);
+
+  // Appending grows capacity geometrically, so a tree that is reused for a
+  // cell's members stops allocating once it has seen its peak occupancy.
+  void Push(double weight);
+  void SwapWithLast(int i);
+  void Pop();
+
+  // Leaves after i move up or down by one to keep the order of the rest,
+  // O(leaves after i)
+  void Insert(int i, double weight);
+  void Erase(int i);
+
+  double Total() const;
+  int Count() const;
+
+  // Index of the leaf whose cumulative weight interval contains u,
+  // u is expected in [0, Total()). Zero-weight leaves are never returned.
+  int Find(double u) const;
+  // Same, also giving how far u is into the leaf's interval
+  int Find(double u, double& rest) const;
+};
+
+#endif
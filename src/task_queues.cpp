@@ -0,0 +1,43 @@
+#include "task_queues.h"
+
+TaskQueues::TaskQueues(int queues, int count) {
+  for (int q = 0; q < queues; ++q) {
+    Queues.emplace_back(new Queue());
+  }
+  for (int task = 0; task < count; ++task) {
+    Queues[task % queues]->Tasks.push_back(task);
+  }
+}
+
+int TaskQueues::Size() const {
+  return Queues.size();
+}
+
+bool TaskQueues::Pop(int queue, bool front, int& task) {
+  Queue& q = *Queues[queue];
+  std::lock_guard<std::mutex> guard(q.Lock);
+  if (q.Tasks.empty()) {
+    return false;
+  }
+  if (front) {
+    task = q.Tasks.front();
+    q.Tasks.pop_front();
+  } else {
+    task = q.Tasks.back();
+    q.Tasks.pop_back();
+  }
+  return true;
+}
+
+bool TaskQueues::Take(int queue, int& task) {
+  if (Pop(queue, true, task)) {
+    return true;
+  }
+  // No task is ever added, so queues found empty stay empty
+  for (int i = 1; i < Size(); ++i) {
+    if (Pop((queue + i) % Size(), false, task)) {
+      return true;
+    }
+  }
+  return false;
+}
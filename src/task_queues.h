@@ -0,0 +1,34 @@
+#ifndef TASK_QUEUES
+#define TASK_QUEUES
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "defines.h"
+
+// Tasks 0 .. count - 1 dealt round robin to one queue per thread. A thread
+// takes tasks from the front of its own queue and, once that is empty, steals
+// from the back of the others, so threads that drew short tasks take over the
+// rest of the work of those that drew long ones. Meant for a few large tasks,
+// each queue has its own lock.
+class TaskQueues {
+  struct Queue {
+    std::mutex Lock;
+    std::deque<int> Tasks;
+  };
+
+  VEC<std::unique_ptr<Queue>> Queues;
+
+  bool Pop(int queue, bool front, int& task);
+
+public:
+  TaskQueues(int queues, int count);
+
+  int Size() const;
+
+  // Next task for the thread of the queue, false once all are taken
+  bool Take(int queue, int& task);
+};
+
+#endif
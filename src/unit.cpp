@@ -9,16 +9,16 @@ Unit::Unit(
   int i
 )
   : cell(cell)
-, _CellDeathRate(cellsDeathRates[cell.species[i]][cellNum])
-, _CellPopulation(cellsPopulation[cell.species[i]][cellNum])
+, _CellDeathRate(cellsDeathRates[cell.Species(i)][cellNum])
+, _CellPopulation(cellsPopulation[cell.Species(i)][cellNum])
 , _CellNum(cellNum)
 , I(i)
 { }
 
 Unit::Unit(Grid& grid, int i, int j)
   : cell(grid.cells[i])
-  , _CellDeathRate(grid.cell_death_rates[cell.species[j]][i])
-  , _CellPopulation(grid.cell_population[cell.species[j]][i])
+  , _CellDeathRate(grid.cell_death_rates[cell.Species(j)][i])
+  , _CellPopulation(grid.cell_population[cell.Species(j)][i])
   , _CellNum(i)
   , I(j)
 {
@@ -26,15 +26,19 @@ Unit::Unit(Grid& grid, int i, int j)
   }
 
 DCoord Unit::Coord() const {
-  return cell.coords_x[I];
+  return cell.Coord(I);
 }
 
 double& Unit::DeathRate() {
-  return cell.death_rates[I];
+  return cell.DeathRate(I);
+}
+
+void Unit::AddInteraction(double interaction) {
+  cell.AddInteraction(I, interaction);
 }
 
 int Unit::Species() const {
-  return cell.species[I];
+  return cell.Species(I);
 }
 
 double& Unit::CellDeathRate() {
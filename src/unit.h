@@ -27,6 +27,8 @@ public:
   
   double& DeathRate();
   
+  void AddInteraction(double interaction);
+  
   int Species() const;
   
   double& CellDeathRate();
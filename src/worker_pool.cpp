@@ -0,0 +1,76 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(int threads)
+  : Generation(0)
+  , Busy(0)
+  , Stopping(false)
+  , Task(nullptr)
+  , Count(0)
+  , Next(0)
+{
+  for (int t = 1; t < threads; ++t) {
+    Workers.emplace_back(&WorkerPool::Work, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> guard(Lock);
+    Stopping = true;
+  }
+  Wake.notify_all();
+  for (std::thread& worker : Workers) {
+    worker.join();
+  }
+}
+
+int WorkerPool::Threads() const {
+  return Workers.size() + 1;
+}
+
+void WorkerPool::Drain() {
+  for (int i = Next++; i < Count; i = Next++) {
+    (*Task)(i);
+  }
+}
+
+void WorkerPool::Work() {
+  long seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(Lock);
+      Wake.wait(guard, [&] { return Stopping || Generation != seen; });
+      if (Stopping) {
+        return;
+      }
+      seen = Generation;
+    }
+    Drain();
+    std::lock_guard<std::mutex> guard(Lock);
+    if (--Busy == 0) {
+      Done.notify_one();
+    }
+  }
+}
+
+void WorkerPool::Run(int count, const std::function<void(int)>& task) {
+  // A single task is not worth waking anyone for
+  if (Workers.empty() || count <= 1) {
+    for (int i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(Lock);
+    Task = &task;
+    Count = count;
+    Next = 0;
+    Busy = Workers.size();
+    ++Generation;
+  }
+  Wake.notify_all();
+  Drain();
+  std::unique_lock<std::mutex> guard(Lock);
+  Done.wait(guard, [&] { return Busy == 0; });
+}
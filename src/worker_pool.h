@@ -0,0 +1,49 @@
+#ifndef WORKER_POOL
+#define WORKER_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "defines.h"
+
+// Threads kept for the lifetime of their owner, so work split into many short
+// parallel phases does not pay for starting threads in each. Run() hands tasks
+// 0 .. count - 1 out one at a time to the workers and the calling thread, so
+// tasks of uneven length are balanced, and returns once all of them are done.
+// Tasks must not call back into R.
+class WorkerPool {
+  VEC<std::thread> Workers;
+
+  std::mutex Lock;
+  std::condition_variable Wake;
+  std::condition_variable Done;
+  // Bumped by every Run(), so each worker joins it once
+  long Generation;
+  // Workers that have not finished the current Run()
+  int Busy;
+  bool Stopping;
+
+  const std::function<void(int)>* Task;
+  int Count;
+  std::atomic<int> Next;
+
+  void Work();
+  void Drain();
+
+public:
+  // Starts threads - 1 workers, the calling thread being the last one
+  explicit WorkerPool(int threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  int Threads() const;
+
+  void Run(int count, const std::function<void(int)>& task);
+};
+
+#endif